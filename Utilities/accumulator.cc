@@ -0,0 +1,270 @@
+#include "accumulator.h"
+
+#include <algorithm>
+#include <climits>
+
+/****************************************************************
+ * Constructor.
+**/
+Accumulator::Accumulator() {
+}
+
+/****************************************************************
+ * Constructor with histogram bins.
+ *
+ * Parameters:
+ *   bin_count - the number of ordinary bins
+ *   bin_width - the range of values that goes in each bin
+**/
+Accumulator::Accumulator(int bin_count, int bin_width) {
+  assert(bin_count >= 0);
+  assert(bin_width > 0);
+  bin_width_ = bin_width;
+  bins_.assign(bin_count, 0);
+}
+
+/****************************************************************
+ * Destructor.
+**/
+Accumulator::~Accumulator() {
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+LONG Accumulator::GetCount() const {
+  return count_;
+}
+
+LONG Accumulator::GetSum() const {
+  return sum_;
+}
+
+double Accumulator::GetMean() const {
+  return mean_;
+}
+
+double Accumulator::GetM2() const {
+  return m2_;
+}
+
+/****************************************************************
+ * The population variance, M2 / count.
+**/
+double Accumulator::GetVariance() const {
+  if(0 == count_) return 0.0;
+  return m2_ / static_cast<double>(count_);
+}
+
+int Accumulator::GetBinCount() const {
+  return static_cast<int>(bins_.size());
+}
+
+int Accumulator::GetBinWidth() const {
+  return bin_width_;
+}
+
+/****************************************************************
+ * The count in one bin. Bins from 'GetBinCount()' up are kept
+ * in the sparse map.
+**/
+LONG Accumulator::GetBin(int bin) const {
+  if(bin < this->GetBinCount()) return bins_.at(bin);
+  auto found = overflow_bins_.find(bin);
+  return (found == overflow_bins_.end()) ? 0 : found->second;
+}
+
+LONG Accumulator::GetOverflow() const {
+  return overflow_;
+}
+
+/****************************************************************
+ * The lowest and highest bins that have anything in them, the
+ * sparse ones included. For an empty accumulator the highest is
+ * less than the lowest.
+**/
+int Accumulator::GetLowestBin() const {
+  return lowest_bin_;
+}
+
+int Accumulator::GetHighestBin() const {
+  return highest_bin_;
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Add one value. Negative values are counted in bin 0.
+ *
+ * Parameters:
+ *   value - the value to add
+ * Return: none
+**/
+void Accumulator::Add(LONG value) {
+  ++count_;
+  sum_ += value;
+  double delta = static_cast<double>(value) - mean_;
+  mean_ += delta / static_cast<double>(count_);
+  m2_ += delta * (static_cast<double>(value) - mean_);
+
+  int bin = 0;
+  if(value > 0)
+  {
+    bin = static_cast<int>(std::min(value / bin_width_,
+                           static_cast<LONG>(INT_MAX)));
+  }
+
+  if(bin < this->GetBinCount())
+  {
+    ++bins_[bin];
+  }
+  else
+  {
+    ++overflow_;
+    ++overflow_bins_[bin];
+  }
+
+  if(1 == count_)
+  {
+    lowest_bin_ = bin;
+    highest_bin_ = bin;
+  }
+  else
+  {
+    if(bin < lowest_bin_) lowest_bin_ = bin;
+    if(bin > highest_bin_) highest_bin_ = bin;
+  }
+}
+
+/****************************************************************
+ * Empty the accumulator but keep its bins.
+**/
+void Accumulator::Clear() {
+  count_ = 0;
+  sum_ = 0;
+  mean_ = 0.0;
+  m2_ = 0.0;
+  for(int bin = lowest_bin_; bin <= highest_bin_; ++bin)
+  {
+    if(bin < this->GetBinCount()) bins_[bin] = 0;
+  }
+  overflow_ = 0;
+  overflow_bins_.clear();
+  lowest_bin_ = 0;
+  highest_bin_ = -1;
+}
+
+/****************************************************************
+ * Count the values in bins above each threshold.
+ *
+ * One pass down the dense bins from the highest builds the
+ * cumulative count from the top, and every threshold is answered
+ * from that. Everything in the sparse bins is above every dense
+ * bin; a threshold among the sparse bins walks their map.
+ *
+ * Parameters:
+ *   thresholds - bin numbers; each answer counts bins > threshold
+ * Returns:
+ *   the counts, in the same order as 'thresholds'
+**/
+std::vector<LONG> Accumulator::CountsAbove(
+                            const std::vector<int>& thresholds) const {
+  std::vector<LONG> counts(thresholds.size(), 0);
+  if(this->IsEmpty()) return counts;
+
+  // at_or_above[b - lowest_bin_] is the count in bins b and up,
+  // for the dense bins that have anything in them
+  int dense_upper = std::min(highest_bin_, this->GetBinCount() - 1);
+  int span = std::max(0, dense_upper - lowest_bin_ + 1);
+  std::vector<LONG> at_or_above(span + 1, 0);
+  at_or_above[span] = overflow_;
+  for(int bin = dense_upper; bin >= lowest_bin_; --bin)
+  {
+    at_or_above[bin - lowest_bin_] = at_or_above[bin - lowest_bin_ + 1]
+                                   + bins_[bin];
+  }
+
+  for(UINT sub = 0; sub < thresholds.size(); ++sub)
+  {
+    int first_above = thresholds[sub] + 1;
+    if(first_above <= lowest_bin_)
+    {
+      counts[sub] = count_;
+    }
+    else if(first_above > highest_bin_)
+    {
+      counts[sub] = 0;
+    }
+    else if(first_above <= dense_upper)
+    {
+      counts[sub] = at_or_above[first_above - lowest_bin_];
+    }
+    else
+    {
+      for(auto iter = overflow_bins_.lower_bound(first_above);
+          iter != overflow_bins_.end(); ++iter)
+      {
+        counts[sub] += iter->second;
+      }
+    }
+  }
+
+  return counts;
+}
+
+/****************************************************************
+ * Return true if nothing has been added.
+**/
+bool Accumulator::IsEmpty() const {
+  return 0 == count_;
+}
+
+/****************************************************************
+ * Merge another accumulator with the same bins into this one.
+ *
+ * The means and M2 combine by the pairwise formula of Chan,
+ * Golub and LeVeque, so the result is the same as having added
+ * every value to one accumulator.
+ *
+ * Parameters:
+ *   other - the accumulator to merge in
+ * Return: none
+**/
+void Accumulator::Merge(const Accumulator& other) {
+  assert(other.bins_.size() == bins_.size());
+  assert(other.bin_width_ == bin_width_);
+  if(other.IsEmpty()) return;
+
+  if(this->IsEmpty())
+  {
+    lowest_bin_ = other.lowest_bin_;
+    highest_bin_ = other.highest_bin_;
+  }
+  else
+  {
+    if(other.lowest_bin_ < lowest_bin_) lowest_bin_ = other.lowest_bin_;
+    if(other.highest_bin_ > highest_bin_) highest_bin_ = other.highest_bin_;
+  }
+
+  double count_a = static_cast<double>(count_);
+  double count_b = static_cast<double>(other.count_);
+  double delta = other.mean_ - mean_;
+  double count_ab = count_a + count_b;
+
+  mean_ += delta * count_b / count_ab;
+  m2_ += other.m2_ + delta * delta * count_a * count_b / count_ab;
+  count_ += other.count_;
+  sum_ += other.sum_;
+
+  for(int bin = other.lowest_bin_; bin <= other.highest_bin_; ++bin)
+  {
+    if(bin < this->GetBinCount()) bins_[bin] += other.bins_[bin];
+  }
+  overflow_ += other.overflow_;
+  for(auto iter = other.overflow_bins_.begin();
+      iter != other.overflow_bins_.end(); ++iter)
+  {
+    overflow_bins_[iter->first] += iter->second;
+  }
+}
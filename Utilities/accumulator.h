@@ -0,0 +1,74 @@
+/****************************************************************
+ * Header for the 'Accumulator' class for running statistics.
+ *
+ * An 'Accumulator' takes values one at a time and keeps
+ * 1.  the count, the exact 64-bit sum, and the mean and the sum of
+ *     squared deviations (M2) by Welford's method,
+ * 2.  a dense histogram of 'bin_count' bins of 'bin_width' each,
+ *     and past the last of them a sparse map of exact bins, so a
+ *     rare long value still lands in its own bin.
+ *
+ * Adding a value is O(1) and nothing is allocated after the
+ * constructor unless a value falls past the dense bins, when it
+ * costs a map insert. Two accumulators with the same bins can be
+ * merged, so threads can each keep their own and combine them at
+ * the end.
+**/
+
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+#include <map>
+#include <vector>
+
+#include "utils.h"
+
+class Accumulator {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ Accumulator();
+ Accumulator(int bin_count, int bin_width);
+ virtual ~Accumulator();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ LONG GetCount() const;
+ LONG GetSum() const;
+ double GetMean() const;
+ double GetM2() const;
+ double GetVariance() const;
+
+ int GetBinCount() const;
+ int GetBinWidth() const;
+ LONG GetBin(int bin) const;
+ LONG GetOverflow() const;
+ int GetLowestBin() const;
+ int GetHighestBin() const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Add(LONG value);
+ void Clear();
+ std::vector<LONG> CountsAbove(const std::vector<int>& thresholds) const;
+ bool IsEmpty() const;
+ void Merge(const Accumulator& other);
+
+private:
+ LONG count_ = 0;
+ LONG sum_ = 0;
+ double mean_ = 0.0;
+ double m2_ = 0.0;
+
+ int bin_width_ = 1;
+ int lowest_bin_ = 0;
+ int highest_bin_ = -1;
+ std::vector<LONG> bins_;
+ LONG overflow_ = 0;
+ std::map<int, LONG> overflow_bins_;
+};
+
+#endif // ACCUMULATOR_H
@@ -0,0 +1,51 @@
+#include "allocstats.h"
+/****************************************************************
+ * The replaced global 'operator new' and 'operator delete', in a
+ * file of their own so that only the programs that count their
+ * allocations (Aprog-alloc) carry them. Every other program uses
+ * the standard operators, with no header on any block.
+**/
+
+#include <new>
+
+static const bool kHooked = AllocStats::Hook();
+
+void* operator new(size_t size) {
+  return AllocStats::Allocate(size, true);
+}
+
+void* operator new[](size_t size) {
+  return AllocStats::Allocate(size, true);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return AllocStats::Allocate(size, false);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return AllocStats::Allocate(size, false);
+}
+
+void operator delete(void* block) noexcept {
+  AllocStats::Free(block);
+}
+
+void operator delete[](void* block) noexcept {
+  AllocStats::Free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+  AllocStats::Free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+  AllocStats::Free(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+  AllocStats::Free(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+  AllocStats::Free(block);
+}
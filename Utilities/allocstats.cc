@@ -0,0 +1,156 @@
+#include "allocstats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <malloc.h>
+#endif
+
+/****************************************************************
+ * One thread's counts. Plain data, so reaching it never
+ * allocates, even while a thread is starting or ending.
+**/
+struct ThreadAllocCounts
+{
+  LONG counts[kAllocCounterCount];
+};
+
+std::atomic<bool> AllocStats::enabled_(false);
+bool AllocStats::hooked_ = false;
+
+/****************************************************************
+ * Every block from the replaced operators starts with this
+ * header, holding the bytes it added to the live count, or zero
+ * if it was allocated before 'Enable'. It is as long as the
+ * strictest alignment, so the caller's part stays aligned.
+**/
+struct alignas(alignof(std::max_align_t)) BlockHeader
+{
+  LONG counted_bytes;
+};
+
+static thread_local ThreadAllocCounts thread_counts = {{0, 0}};
+static std::atomic<LONG> live_bytes(0);
+static std::atomic<LONG> peak_live_bytes(0);
+
+/****************************************************************
+ * The size malloc really set aside for the caller's part of
+ * 'block', leaving out its header.
+**/
+static LONG BlockSize(void* block, size_t asked)
+{
+#ifdef __linux__
+  (void)asked;
+  return static_cast<LONG>(malloc_usable_size(block)
+                           - sizeof(BlockHeader));
+#else
+  (void)block;
+  return static_cast<LONG>(asked);
+#endif
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+LONG AllocStats::GetLiveBytes() {
+  return live_bytes.load(std::memory_order_relaxed);
+}
+
+LONG AllocStats::GetPeakLiveBytes() {
+  return peak_live_bytes.load(std::memory_order_relaxed);
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * The allocation behind every replaced 'operator new'. As the
+ * standard ones do, it calls the new handler and tries again
+ * until malloc succeeds or there is no handler; the nothrow forms
+ * turn a 'bad_alloc' from the handler into a null return.
+**/
+void* AllocStats::Allocate(size_t size, bool can_throw) {
+  if(0 == size) size = 1;
+  if(size > SIZE_MAX - sizeof(BlockHeader))
+  {
+    if(can_throw) throw std::bad_alloc();
+    return nullptr;
+  }
+  void* block = nullptr;
+  while(nullptr == (block = malloc(sizeof(BlockHeader) + size)))
+  {
+    std::new_handler handler = std::get_new_handler();
+    if(nullptr == handler)
+    {
+      if(can_throw) throw std::bad_alloc();
+      return nullptr;
+    }
+    if(can_throw)
+    {
+      handler();
+      continue;
+    }
+    try
+    {
+      handler();
+    }
+    catch(const std::bad_alloc&)
+    {
+      return nullptr;
+    }
+  }
+
+  BlockHeader* header = static_cast<BlockHeader*>(block);
+  header->counted_bytes = 0;
+  if(!IsEnabled()) return header + 1;
+
+  LONG bytes = BlockSize(block, size);
+  header->counted_bytes = bytes;
+  ++thread_counts.counts[kAllocCalls];
+  thread_counts.counts[kAllocBytes] += bytes;
+  LONG live = live_bytes.fetch_add(bytes, std::memory_order_relaxed)
+              + bytes;
+  LONG peak = peak_live_bytes.load(std::memory_order_relaxed);
+  while((live > peak) &&
+        !peak_live_bytes.compare_exchange_weak(peak, live,
+                                               std::memory_order_relaxed))
+  {
+  }
+  return header + 1;
+}
+
+void AllocStats::Enable() {
+  enabled_.store(true);
+}
+
+/****************************************************************
+ * Called from the static initializer of 'allochook.cc', so only
+ * a program linked with the replaced operators says it is hooked.
+**/
+bool AllocStats::Hook() {
+  hooked_ = true;
+  return hooked_;
+}
+
+/****************************************************************
+ * The free behind every replaced 'operator delete'. Only the
+ * bytes a block added to the live count come off it, so blocks
+ * from before 'Enable' leave it alone.
+**/
+void AllocStats::Free(void* block) {
+  if(nullptr == block) return;
+  BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+  if(0 != header->counted_bytes)
+    live_bytes.fetch_sub(header->counted_bytes,
+                         std::memory_order_relaxed);
+  free(header);
+}
+
+void AllocStats::Read(LONG counts[kAllocCounterCount]) {
+  for(int which = 0; which < kAllocCounterCount; ++which)
+  {
+    counts[which] = thread_counts.counts[which];
+  }
+}
@@ -0,0 +1,69 @@
+/****************************************************************
+ * Header for the 'AllocStats' class.
+ *
+ * 'AllocStats' counts what the program allocates. It only sees
+ * the allocations of a program linked with 'allochook.o', which
+ * replaces the global 'operator new' and 'operator delete' (not
+ * the aligned ones); the makefile builds Aprog-alloc that way and
+ * leaves Aprog and the other programs with the standard ones.
+ * In a hooked program every block goes to malloc and free with a
+ * small header in front of it. Nothing is counted until 'Enable'
+ * is called. From then on each thread counts its own allocations
+ * and bytes, with no locking, and the bytes live in the whole
+ * process, and their peak, are kept with atomics. Sizes are the
+ * ones malloc really gave, from 'malloc_usable_size' where there
+ * is one.
+ *
+ * Live bytes start from zero at 'Enable'. Each block's header
+ * holds the bytes it added, so a block allocated before then and
+ * freed after takes nothing off.
+ *
+ * 'ScopedTimer' reads the thread's counts around every timer, so
+ * its report can put the allocations under the precinct and
+ * phase they happened in.
+**/
+
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+#include <atomic>
+
+#include "utils.h"
+
+static const int kAllocCounterCount = 2;
+static const int kAllocCalls = 0;
+static const int kAllocBytes = 1;
+
+class AllocStats {
+public:
+/****************************************************************
+ * Accessors and mutators.
+**/
+ static LONG GetLiveBytes();
+ static LONG GetPeakLiveBytes();
+ static bool IsEnabled() {
+   return enabled_.load(std::memory_order_relaxed);
+ }
+ // True if the replaced operators are linked in
+ static bool IsHooked() {
+   return hooked_;
+ }
+
+/****************************************************************
+ * General functions.
+**/
+ static void Enable();
+ // The calling thread's allocations and bytes since 'Enable'
+ static void Read(LONG counts[kAllocCounterCount]);
+
+ // For the replaced operators only
+ static void* Allocate(size_t size, bool can_throw);
+ static void Free(void* block);
+ static bool Hook();
+
+private:
+ static std::atomic<bool> enabled_;
+ static bool hooked_;
+};
+
+#endif // ALLOCSTATS_H
@@ -0,0 +1,191 @@
+#include "asyncwriter.h"
+
+#include "eventtrace.h"
+
+/****************************************************************
+ * Constructor.
+**/
+AsyncWriter::AsyncWriter() {
+}
+
+/****************************************************************
+ * Destructor.
+**/
+AsyncWriter::~AsyncWriter() {
+  this->Stop();
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+bool AsyncWriter::IsRunning() const {
+  return running_;
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Wait until everything queued so far is written and flushed.
+**/
+void AsyncWriter::Flush() {
+  if(!running_) return;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  LONG target = records_queued_;
+  if(target > flush_wanted_) flush_wanted_ = target;
+  work_ready_.notify_one();
+  flush_done_.wait(lock, [this, target] {
+    return records_flushed_ >= target;
+  });
+}
+
+/****************************************************************
+ * Start the writer thread.
+ *
+ * Parameters:
+ *   max_queued_bytes - the most text to hold before producers
+ *                      wait; one string longer than this is
+ *                      still taken, once the queue is empty
+ *   tee - a sink for strings bound for its two streams, or null
+**/
+void AsyncWriter::Start(size_t max_queued_bytes, TeeSink* tee) {
+  assert(!running_);
+  max_queued_bytes_ = max_queued_bytes;
+  tee_ = tee;
+  stopping_ = false;
+  running_ = true;
+  thread_ = std::thread(&AsyncWriter::Run, this);
+}
+
+/****************************************************************
+ * Write everything still queued, flush, and end the thread.
+**/
+void AsyncWriter::Stop() {
+  if(!running_) return;
+
+  this->Flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    work_ready_.notify_one();
+  }
+  thread_.join();
+  running_ = false;
+}
+
+/****************************************************************
+ * Queue 'text' for one or two streams, waiting first if the
+ * queue is over its limit. 'second_stream' may be null.
+**/
+void AsyncWriter::Write(std::string text, std::ofstream* first_stream,
+                        std::ofstream* second_stream) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  room_ready_.wait(lock, [this, &text] {
+    return (0 == queued_bytes_) ||
+           (queued_bytes_ + text.size() <= max_queued_bytes_);
+  });
+
+  queued_bytes_ += text.size();
+  EventTrace::AddCounter("async output bytes",
+                         static_cast<LONG>(queued_bytes_));
+  ++records_queued_;
+  queue_.push_back(Record{std::move(text), first_stream, second_stream});
+  work_ready_.notify_one();
+}
+
+/****************************************************************
+ * The writer thread. Takes the whole queue at a time, writes it
+ * with one call per stream (or one call to the tee sink for the
+ * strings bound for its pair), and flushes when a flush is
+ * wanted. The tee sink writes its files directly, so it needs no
+ * flushing.
+ * The bytes stay counted against the limit until they are
+ * written, so the limit covers the batch being written too.
+**/
+void AsyncWriter::Run() {
+  EventTrace::NameThread("async writer");
+  std::deque<Record> batch;
+  std::vector<std::pair<std::ofstream*, std::string> > joined;
+  std::string tee_text;
+
+  while(true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_ready_.wait(lock, [this] {
+        return stopping_ || !queue_.empty() ||
+               (flush_wanted_ > records_flushed_);
+      });
+      if(stopping_ && queue_.empty()) break;
+      batch.swap(queue_);
+    }
+
+    size_t batch_bytes = 0;
+    for(UINT sub = 0; sub < joined.size(); ++sub)
+    {
+      joined[sub].second.clear();
+    }
+    tee_text.clear();
+    for(UINT sub = 0; sub < batch.size(); ++sub)
+    {
+      batch_bytes += batch[sub].text.size();
+      if((nullptr != tee_) &&
+         tee_->Matches(batch[sub].first_stream, batch[sub].second_stream))
+      {
+        tee_text.append(batch[sub].text);
+        continue;
+      }
+      AddText(joined, batch[sub].first_stream, batch[sub].text);
+      if(nullptr != batch[sub].second_stream)
+        AddText(joined, batch[sub].second_stream, batch[sub].text);
+    }
+    for(UINT sub = 0; sub < joined.size(); ++sub)
+    {
+      if(joined[sub].second.empty()) continue;
+      joined[sub].first->write(joined[sub].second.data(),
+                               joined[sub].second.size());
+    }
+    if(!tee_text.empty()) tee_->Write(tee_text.data(), tee_text.size());
+    LONG batch_records = static_cast<LONG>(batch.size());
+    batch.clear();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    queued_bytes_ -= batch_bytes;
+    EventTrace::AddCounter("async output bytes",
+                           static_cast<LONG>(queued_bytes_));
+    records_written_ += batch_records;
+    room_ready_.notify_all();
+
+    if(flush_wanted_ > records_flushed_ && records_written_ >= flush_wanted_)
+    {
+      LONG flushed = records_written_;
+      lock.unlock();
+      for(UINT sub = 0; sub < joined.size(); ++sub)
+      {
+        joined[sub].first->flush();
+      }
+      lock.lock();
+      records_flushed_ = flushed;
+      flush_done_.notify_all();
+    }
+  }
+}
+
+/****************************************************************
+ * Add 'text' to the joined text for 'stream', making an entry
+ * for a stream not seen before. There are only ever a few.
+**/
+void AsyncWriter::AddText(
+       std::vector<std::pair<std::ofstream*, std::string> >& joined,
+       std::ofstream* stream, const std::string& text) {
+  for(UINT sub = 0; sub < joined.size(); ++sub)
+  {
+    if(joined[sub].first == stream)
+    {
+      joined[sub].second.append(text);
+      return;
+    }
+  }
+  joined.push_back(std::make_pair(stream, text));
+}
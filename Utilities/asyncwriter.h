@@ -0,0 +1,97 @@
+/****************************************************************
+ * Header for the 'AsyncWriter' class.
+ *
+ * An 'AsyncWriter' takes strings to be written to one or two
+ * 'ofstream's and writes them on its own thread, so the threads
+ * producing output never wait on the disk.
+ *
+ * 1.  Each time the writer thread wakes it takes everything that
+ *     is queued at once, joins the text for each stream, and
+ *     writes each stream with one call.
+ * 2.  The queue is bounded by bytes, not by count. A producer
+ *     that would take it past 'max_queued_bytes' waits until the
+ *     writer has caught up, so memory stays bounded even if the
+ *     disk is much slower than the simulation.
+ * 3.  'Flush' is a flush point: it returns once everything queued
+ *     before it has been written and the streams flushed.
+ * 4.  'Stop' flushes and ends the thread; the destructor stops a
+ *     writer that is still running.
+ *
+ * Each stream gets its strings in the order they were queued.
+ * Nothing else may write to those streams while it is running.
+ *
+ * Given a 'TeeSink', strings for the sink's pair of streams are
+ * joined once and written through the sink to both files.
+**/
+
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "teesink.h"
+#include "utils.h"
+
+class AsyncWriter {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ AsyncWriter();
+ AsyncWriter(const AsyncWriter&) = delete;
+ AsyncWriter& operator=(const AsyncWriter&) = delete;
+ virtual ~AsyncWriter();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ bool IsRunning() const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Flush();
+ void Start(size_t max_queued_bytes, TeeSink* tee);
+ void Stop();
+ void Write(std::string text, std::ofstream* first_stream,
+            std::ofstream* second_stream);
+
+private:
+ struct Record {
+   std::string text;
+   std::ofstream* first_stream;
+   std::ofstream* second_stream;
+ };
+
+ size_t max_queued_bytes_ = 0;
+ TeeSink* tee_ = nullptr;
+ bool running_ = false;
+ bool stopping_ = false;
+
+ std::deque<Record> queue_;
+ size_t queued_bytes_ = 0;
+ LONG records_queued_ = 0;
+ LONG records_written_ = 0;
+ LONG flush_wanted_ = 0;
+ LONG records_flushed_ = 0;
+
+ std::mutex mutex_;
+ std::condition_variable work_ready_;
+ std::condition_variable room_ready_;
+ std::condition_variable flush_done_;
+ std::thread thread_;
+
+ void Run();
+ static void AddText(std::vector<std::pair<std::ofstream*, std::string> >&
+                     joined, std::ofstream* stream, const std::string& text);
+};
+
+#endif // ASYNCWRITER_H
@@ -0,0 +1,99 @@
+/****************************************************************
+ * Header for the 'BoundedQueue' template class.
+ *
+ * A 'BoundedQueue' is a first-in first-out queue for handing
+ * work from one thread to another. It holds at most 'capacity'
+ * items: 'Push' waits while it is full and 'Pop' waits while it
+ * is empty, so a fast stage can never get more than 'capacity'
+ * items ahead of a slow one.
+ *
+ * 'Close' says no more items are coming. Pushing after that is
+ * an error, and 'Pop' returns false once the queue is closed
+ * and empty, which is how the consuming threads know to stop.
+ *
+ * The whole class is in this header because it is a template.
+**/
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+template <typename T>
+class BoundedQueue {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ explicit BoundedQueue(int capacity) : capacity_(capacity) {
+   assert(capacity > 0);
+ }
+ BoundedQueue(const BoundedQueue&) = delete;
+ BoundedQueue& operator=(const BoundedQueue&) = delete;
+ virtual ~BoundedQueue() {}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Say that nothing more will be pushed, and wake every thread
+ * waiting in 'Pop'.
+**/
+ void Close() {
+   std::lock_guard<std::mutex> lock(mutex_);
+   closed_ = true;
+   not_empty_.notify_all();
+ }
+
+/****************************************************************
+ * Take the oldest item, waiting for one if necessary.
+ *
+ * Returns:
+ *   false if the queue is closed and empty, and 'item' is unset
+**/
+ bool Pop(T& item) {
+   std::unique_lock<std::mutex> lock(mutex_);
+   not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+   if(items_.empty()) return false;
+
+   item = std::move(items_.front());
+   items_.pop_front();
+   not_full_.notify_one();
+   return true;
+ }
+
+/****************************************************************
+ * Add an item, waiting for room if the queue is full.
+**/
+ void Push(T item) {
+   std::unique_lock<std::mutex> lock(mutex_);
+   not_full_.wait(lock, [this] {
+     return static_cast<int>(items_.size()) < capacity_;
+   });
+   assert(!closed_);
+
+   items_.push_back(std::move(item));
+   not_empty_.notify_one();
+ }
+
+/****************************************************************
+ * The number of items waiting now, for watching the queue.
+**/
+ int Size() {
+   std::lock_guard<std::mutex> lock(mutex_);
+   return static_cast<int>(items_.size());
+ }
+
+private:
+ int capacity_;
+ bool closed_ = false;
+ std::deque<T> items_;
+ std::mutex mutex_;
+ std::condition_variable not_empty_;
+ std::condition_variable not_full_;
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,208 @@
+#include "eventtrace.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "formatter.h"
+
+// Events written from the formatter to the file at a time
+static const int kWriteBatchEvents = 4096;
+
+/****************************************************************
+ * One recorded event: a span ('X') or a counter value ('C').
+**/
+struct TraceEvent
+{
+  const char* name;
+  LONG value;
+  LONG start_ns;
+  LONG duration_ns;
+  char phase;
+  bool has_value;
+};
+
+/****************************************************************
+ * One thread's ring. 'next' counts every event ever recorded, so
+ * the ring has wrapped once 'next' passes its size.
+**/
+struct EventRing
+{
+  int tid;
+  std::string name;
+  std::vector<TraceEvent> events;
+  LONG next;
+};
+
+std::atomic<bool> EventTrace::enabled_(false);
+
+static std::mutex rings_mutex;
+static std::vector<std::unique_ptr<EventRing> > all_rings;
+static thread_local EventRing* thread_ring = nullptr;
+static int ring_capacity = 0;
+static LONG trace_start_ns = 0;
+
+static LONG NowNanoseconds()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/****************************************************************
+ * This thread's ring, made and registered the first time.
+**/
+static EventRing* GetThreadRing()
+{
+  if(nullptr == thread_ring)
+  {
+    std::unique_ptr<EventRing> ring(new EventRing());
+    ring->events.resize(ring_capacity);
+    ring->next = 0;
+    thread_ring = ring.get();
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    ring->tid = static_cast<int>(all_rings.size()) + 1;
+    all_rings.push_back(std::move(ring));
+  }
+  return thread_ring;
+}
+
+/****************************************************************
+ * Put an event in this thread's ring, over its oldest if full.
+**/
+static void Record(const TraceEvent& event)
+{
+  EventRing* ring = GetThreadRing();
+  ring->events[ring->next % ring_capacity] = event;
+  ++ring->next;
+}
+
+/****************************************************************
+ * Nanoseconds since 'Enable' as the microseconds the format
+ * wants.
+**/
+static void AppendMicroseconds(LONG ns, Formatter& lines)
+{
+  lines.AppendFixed(ns / 1000.0, 1, 3);
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Record the value of a counter track now.
+**/
+void EventTrace::AddCounter(const char* name, LONG value) {
+  if(!IsEnabled()) return;
+  Record(TraceEvent{name, value, NowNanoseconds(), 0, 'C', true});
+}
+
+/****************************************************************
+ * Record a span on this thread, from the same monotonic clock
+ * that 'ScopedTimer' reads.
+**/
+void EventTrace::AddSpan(const char* name, bool has_value, LONG value,
+                         LONG start_ns, LONG end_ns) {
+  if(!IsEnabled()) return;
+  Record(TraceEvent{name, value, start_ns, end_ns - start_ns, 'X',
+                    has_value});
+}
+
+/****************************************************************
+ * Start recording, with rings of 'capacity' events.
+**/
+void EventTrace::Enable(int capacity) {
+  ring_capacity = (capacity > 0) ? capacity : 1;
+  trace_start_ns = NowNanoseconds();
+  enabled_.store(true);
+}
+
+void EventTrace::NameThread(const std::string& name) {
+  if(!IsEnabled()) return;
+  GetThreadRing()->name = name;
+}
+
+/****************************************************************
+ * Write every ring to 'filename' as a JSON trace-event file,
+ * each thread's events oldest first, with the thread's name as
+ * metadata.
+ *
+ * Returns:
+ *   a line saying how many events were written and dropped
+**/
+std::string EventTrace::Write(const std::string& filename) {
+  std::ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+
+  Formatter lines;
+  lines.Append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  LONG written = 0;
+  LONG dropped = 0;
+  bool first = true;
+
+  std::lock_guard<std::mutex> lock(rings_mutex);
+  for(UINT sub = 0; sub < all_rings.size(); ++sub)
+  {
+    const EventRing& ring = *all_rings[sub];
+    std::string name = ring.name;
+    if(name == "") name = "thread " + std::to_string(ring.tid);
+    lines.Append(first ? "" : ",\n");
+    first = false;
+    lines.Append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+    lines.AppendInt(ring.tid, 1);
+    lines.Append(",\"args\":{\"name\":\"" + name + "\"}}");
+
+    LONG oldest = 0;
+    if(ring.next > ring_capacity)
+    {
+      oldest = ring.next - ring_capacity;
+      dropped += oldest;
+    }
+    for(LONG count = oldest; count < ring.next; ++count)
+    {
+      const TraceEvent& event = ring.events[count % ring_capacity];
+      lines.Append(",\n{\"name\":\"");
+      lines.Append(event.name);
+      if(('X' == event.phase) && event.has_value)
+      {
+        lines.Append(" ");
+        lines.AppendInt(event.value, 1);
+      }
+      lines.Append("\",\"ph\":\"");
+      lines.Append(std::string(1, event.phase));
+      lines.Append("\",\"pid\":1,\"tid\":");
+      lines.AppendInt(ring.tid, 1);
+      lines.Append(",\"ts\":");
+      AppendMicroseconds(event.start_ns - trace_start_ns, lines);
+      if('X' == event.phase)
+      {
+        lines.Append(",\"dur\":");
+        AppendMicroseconds(event.duration_ns, lines);
+      }
+      if(event.has_value)
+      {
+        lines.Append(",\"args\":{\"value\":");
+        lines.AppendInt(event.value, 1);
+        lines.Append("}");
+      }
+      lines.Append("}");
+      ++written;
+
+      if(0 == written % kWriteBatchEvents)
+      {
+        out_stream << lines.GetString();
+        lines.Clear();
+      }
+    }
+  }
+
+  lines.Append("\n],\"otherData\":{\"dropped_events\":");
+  lines.AppendInt(dropped, 1);
+  lines.Append("}}\n");
+  out_stream << lines.GetString();
+  Utils::FileClose(out_stream);
+
+  return "wrote " + std::to_string(written) + " trace events to '"
+         + filename + "' (" + std::to_string(dropped) + " dropped)\n";
+}
@@ -0,0 +1,55 @@
+/****************************************************************
+ * Header for the 'EventTrace' class.
+ *
+ * 'EventTrace' records a timeline of the run for the Chrome
+ * trace viewer (chrome://tracing) or Perfetto (ui.perfetto.dev):
+ * a span for every 'ScopedTimer' on every thread, and counter
+ * tracks for values such as queue depths.
+ *
+ * Each thread records into its own ring of 'capacity' events,
+ * made the first time it records, with no locking and nothing
+ * allocated after that, so recording costs little more than
+ * reading the clock. A thread that records more than its ring
+ * holds keeps its latest events; 'Write' says how many were
+ * dropped.
+ *
+ * Nothing is recorded until 'Enable'. 'Write' merges the rings
+ * into one JSON trace-event file; call it only when no thread
+ * that recorded is still running. Names must be string literals
+ * (or outlive the trace) and need no JSON escaping.
+**/
+
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include <atomic>
+#include <string>
+
+#include "utils.h"
+
+class EventTrace {
+public:
+/****************************************************************
+ * Accessors and mutators.
+**/
+ static bool IsEnabled() {
+   return enabled_.load(std::memory_order_relaxed);
+ }
+
+/****************************************************************
+ * General functions.
+**/
+ static void AddCounter(const char* name, LONG value);
+ static void AddSpan(const char* name, bool has_value, LONG value,
+                     LONG start_ns, LONG end_ns);
+ static void Enable(int capacity);
+ // Names the calling thread's track in the viewer
+ static void NameThread(const std::string& name);
+ // Returns a line for the report, saying what was written
+ static std::string Write(const std::string& filename);
+
+private:
+ static std::atomic<bool> enabled_;
+};
+
+#endif // EVENTTRACE_H
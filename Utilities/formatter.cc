@@ -0,0 +1,106 @@
+#include "formatter.h"
+
+#include <charconv>
+
+// Room for any LONG, or any double to_chars can be asked for here
+static const int kNumberChars = 512;
+
+/****************************************************************
+ * Constructor.
+**/
+Formatter::Formatter() {
+}
+
+/****************************************************************
+ * Destructor.
+**/
+Formatter::~Formatter() {
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+const std::string& Formatter::GetString() const {
+  return buffer_;
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Add text as it is.
+**/
+void Formatter::Append(std::string_view text) {
+  buffer_.append(text.data(), text.size());
+}
+
+/****************************************************************
+ * Add a double, padded to 'width' on the right if 'left' and on
+ * the left otherwise. If 'fixed' it has 'precision' digits after
+ * the point, as with 'std::fixed'. If not it is written the way
+ * a stream does by default, like printf's '%g' with 'precision'
+ * significant digits.
+**/
+void Formatter::AppendDouble(double value, int width, int precision,
+                             bool fixed, bool left) {
+  char digits[kNumberChars];
+  std::chars_format format = fixed ? std::chars_format::fixed
+                                   : std::chars_format::general;
+  std::to_chars_result result = std::to_chars(digits, digits + kNumberChars,
+                                              value, format, precision);
+  this->AppendPadded(digits, result.ptr, width, left);
+}
+
+/****************************************************************
+ * Add a double with 'precision' digits after the point, padded
+ * on the left to 'width'. Same as 'Utils::Format(value, width,
+ * precision)'.
+**/
+void Formatter::AppendFixed(double value, int width, int precision) {
+  this->AppendDouble(value, width, precision, true, false);
+}
+
+/****************************************************************
+ * Add an integer padded on the left to 'width'.
+**/
+void Formatter::AppendInt(LONG value, int width) {
+  char digits[kNumberChars];
+  std::to_chars_result result = std::to_chars(digits, digits + kNumberChars,
+                                              value);
+  this->AppendPadded(digits, result.ptr, width, false);
+}
+
+/****************************************************************
+ * Add text padded on the right to 'width'.
+**/
+void Formatter::AppendLeft(std::string_view text, int width) {
+  this->AppendPadded(text.data(), text.data() + text.size(), width, true);
+}
+
+/****************************************************************
+ * Add text padded on the left to 'width'.
+**/
+void Formatter::AppendRight(std::string_view text, int width) {
+  this->AppendPadded(text.data(), text.data() + text.size(), width, false);
+}
+
+/****************************************************************
+ * Empty the buffer but keep its memory for the next line.
+**/
+void Formatter::Clear() {
+  buffer_.clear();
+}
+
+/****************************************************************
+ * Add [begin, end) padded with blanks to 'width', on the right
+ * if 'left' and otherwise on the left.
+**/
+void Formatter::AppendPadded(const char* begin, const char* end, int width,
+                             bool left) {
+  int length = static_cast<int>(end - begin);
+  int padding = (width > length) ? width - length : 0;
+
+  if(!left) buffer_.append(padding, ' ');
+  buffer_.append(begin, length);
+  if(left) buffer_.append(padding, ' ');
+}
@@ -0,0 +1,56 @@
+/****************************************************************
+ * Header for the 'Formatter' class.
+ *
+ * A 'Formatter' builds a line of fixed-width columns in a buffer
+ * the caller owns and reuses. Numbers are converted with
+ * 'std::to_chars' straight into the buffer and padded there, so
+ * once the buffer has grown to the longest line nothing is
+ * allocated, and no stream or locale is involved.
+ *
+ * The columns come out exactly as the 'Utils::Format' functions
+ * make them: integers and fixed-point doubles are padded on the
+ * left, text on either side, and nothing is ever truncated to
+ * fit its width.
+**/
+
+#ifndef FORMATTER_H
+#define FORMATTER_H
+
+#include <string>
+#include <string_view>
+
+#include "utils.h"
+
+class Formatter {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ Formatter();
+ virtual ~Formatter();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ const std::string& GetString() const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Append(std::string_view text);
+ void AppendDouble(double value, int width, int precision, bool fixed,
+                   bool left);
+ void AppendFixed(double value, int width, int precision);
+ void AppendInt(LONG value, int width);
+ void AppendLeft(std::string_view text, int width);
+ void AppendRight(std::string_view text, int width);
+ void Clear();
+
+private:
+ std::string buffer_;
+
+ void AppendPadded(const char* begin, const char* end, int width,
+                   bool left);
+};
+
+#endif // FORMATTER_H
@@ -0,0 +1,92 @@
+#include "mappedfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/****************************************************************
+ * Constructor.
+**/
+MappedFile::MappedFile() {
+}
+
+/****************************************************************
+ * Destructor. Unmaps the file if it is still mapped.
+**/
+MappedFile::~MappedFile() {
+  this->Close();
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+const char* MappedFile::GetData() const {
+  return data_;
+}
+
+size_t MappedFile::GetSize() const {
+  return size_;
+}
+
+bool MappedFile::IsOpen() const {
+  return is_open_;
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Unmap the file.
+**/
+void MappedFile::Close() {
+  if((nullptr != data_) && (size_ > 0))
+  {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  is_open_ = false;
+}
+
+/****************************************************************
+ * Map a file. An empty regular file opens with no data.
+ *
+ * Parameters:
+ *   filename - the name of the file to be mapped
+ * Returns:
+ *   true if the file is mapped, false if it does not exist or
+ *   is not a regular file
+**/
+bool MappedFile::Open(const std::string filename) {
+  this->Close();
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+
+  struct stat file_stat;
+  if((fstat(fd, &file_stat) != 0) || !S_ISREG(file_stat.st_mode))
+  {
+    close(fd);
+    return false;
+  }
+
+  size_ = static_cast<size_t>(file_stat.st_size);
+  if(size_ > 0)
+  {
+    void* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(MAP_FAILED == address)
+    {
+      close(fd);
+      size_ = 0;
+      return false;
+    }
+    madvise(address, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(address);
+  }
+
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  is_open_ = true;
+  return true;
+}
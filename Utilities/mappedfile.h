@@ -0,0 +1,47 @@
+/****************************************************************
+ * Header for the 'MappedFile' class.
+ *
+ * A 'MappedFile' maps a whole regular file read-only into memory
+ * with 'mmap', so it can be read in place without copying it
+ * through stream buffers. Processes mapping the same file share
+ * its pages through the page cache. Pipes and other files that
+ * cannot be mapped make 'Open' return false, and the caller can
+ * fall back to reading them as a stream.
+**/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ MappedFile();
+ MappedFile(const MappedFile&) = delete;
+ MappedFile& operator=(const MappedFile&) = delete;
+ virtual ~MappedFile();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ const char* GetData() const;
+ size_t GetSize() const;
+ bool IsOpen() const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Close();
+ bool Open(const std::string filename);
+
+private:
+ const char* data_ = nullptr;
+ size_t size_ = 0;
+ bool is_open_ = false;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,155 @@
+#include "perfcounters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/****************************************************************
+ * Constructor.
+**/
+PerfCounters::PerfCounters() {
+}
+
+/****************************************************************
+ * Destructor.
+**/
+PerfCounters::~PerfCounters() {
+  this->Close();
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+const std::string& PerfCounters::GetError() const {
+  return error_;
+}
+
+bool PerfCounters::IsOpen() const {
+  return fds_[kPerfCycles] >= 0;
+}
+
+/****************************************************************
+ * The short name of a counter, for report headings.
+**/
+const char* PerfCounters::GetName(int which) {
+  static const char* names[kPerfCounterCount] = {
+    "cycles", "instructions", "br-miss", "L1d-miss", "LLC-miss"
+  };
+  return names[which];
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Close every counter of the group.
+**/
+void PerfCounters::Close() {
+  for(int which = kPerfCounterCount - 1; which >= 0; --which)
+  {
+    if(fds_[which] >= 0) close(fds_[which]);
+    fds_[which] = -1;
+  }
+}
+
+/****************************************************************
+ * Open the group on the calling thread and start it counting.
+ * The cycles counter leads the group; the others join it, or
+ * are left out if this machine cannot count them.
+ *
+ * Returns:
+ *   true if at least cycles are being counted
+**/
+bool PerfCounters::Open() {
+  this->Close();
+#ifdef __linux__
+  static const uint32_t types[kPerfCounterCount] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+    PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+  };
+  static const uint64_t configs[kPerfCounterCount] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_CACHE_MISSES
+  };
+
+  for(int which = 0; which < kPerfCounterCount; ++which)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = types[which];
+    attr.config = configs[which];
+    attr.disabled = (kPerfCycles == which) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                       | PERF_FORMAT_TOTAL_TIME_ENABLED
+                       | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int group_fd = (kPerfCycles == which) ? -1 : fds_[kPerfCycles];
+    long fd = syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+    if(fd < 0)
+    {
+      if(kPerfCycles == which)
+      {
+        error_ = std::string(strerror(errno));
+        return false;
+      }
+      continue;
+    }
+    fds_[which] = static_cast<int>(fd);
+    ioctl(fds_[which], PERF_EVENT_IOC_ID, &ids_[which]);
+  }
+
+  ioctl(fds_[kPerfCycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[kPerfCycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  error_ = "";
+  return true;
+#else
+  error_ = "perf_event_open is only on Linux";
+  return false;
+#endif
+}
+
+/****************************************************************
+ * Read the whole group at once. Each count is scaled by the
+ * time the group was enabled over the time it really ran, which
+ * is 1 unless the kernel multiplexed the counters.
+**/
+void PerfCounters::Read(uint64_t counts[kPerfCounterCount]) const {
+  for(int which = 0; which < kPerfCounterCount; ++which)
+  {
+    counts[which] = 0;
+  }
+  if(!this->IsOpen()) return;
+
+  // nr, time enabled, time running, then a value and id for each
+  uint64_t buffer[3 + 2 * kPerfCounterCount];
+  ssize_t got = read(fds_[kPerfCycles], buffer, sizeof(buffer));
+  if(got < static_cast<ssize_t>(3 * sizeof(uint64_t))) return;
+
+  uint64_t count = buffer[0];
+  double scale = 1.0;
+  if((buffer[2] > 0) && (buffer[2] < buffer[1]))
+    scale = static_cast<double>(buffer[1]) / buffer[2];
+
+  for(uint64_t sub = 0; (sub < count) && (sub < kPerfCounterCount); ++sub)
+  {
+    uint64_t value = buffer[3 + 2 * sub];
+    uint64_t id = buffer[4 + 2 * sub];
+    for(int which = 0; which < kPerfCounterCount; ++which)
+    {
+      if((fds_[which] >= 0) && (ids_[which] == id))
+        counts[which] = static_cast<uint64_t>(value * scale);
+    }
+  }
+}
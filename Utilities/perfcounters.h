@@ -0,0 +1,64 @@
+/****************************************************************
+ * Header for the 'PerfCounters' class.
+ *
+ * A 'PerfCounters' is one group of hardware counters, opened
+ * with 'perf_event_open' on the thread that calls 'Open' and
+ * counting only that thread, in user mode:
+ *   cycles, instructions, branch misses,
+ *   L1 data cache read misses, last level cache misses
+ * The group is read with one 'read' call, and the counts are
+ * scaled up if the kernel had to share the counters out.
+ *
+ * Counters are often not allowed (perf_event_paranoid, a
+ * container, a virtual machine without a PMU). If cycles cannot
+ * be counted 'Open' returns false and 'GetError' says why; any
+ * other counter that cannot be opened just reads as zero.
+**/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+#include "utils.h"
+
+static const int kPerfCounterCount = 5;
+static const int kPerfCycles = 0;
+static const int kPerfInstructions = 1;
+static const int kPerfBranchMisses = 2;
+static const int kPerfL1dMisses = 3;
+static const int kPerfLlcMisses = 4;
+
+class PerfCounters {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ PerfCounters();
+ PerfCounters(const PerfCounters&) = delete;
+ PerfCounters& operator=(const PerfCounters&) = delete;
+ virtual ~PerfCounters();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ const std::string& GetError() const;
+ bool IsOpen() const;
+ static const char* GetName(int which);
+
+/****************************************************************
+ * General functions.
+**/
+ void Close();
+ bool Open();
+ // The counts since 'Open', all zero if the group is not open
+ void Read(uint64_t counts[kPerfCounterCount]) const;
+
+private:
+ int fds_[kPerfCounterCount] = {-1, -1, -1, -1, -1};
+ uint64_t ids_[kPerfCounterCount] = {0, 0, 0, 0, 0};
+ std::string error_ = "";
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,324 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <cstdint>
+#include <dlfcn.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <thread>
+#include <ucontext.h>
+#include <unistd.h>
+#include <vector>
+
+// Samples waiting to be emptied at once, and frames kept of each
+static const int kProfileSlots = 1024;
+static const int kProfileFrames = 64;
+// Frame pointers further than this above the interrupted stack
+// pointer are taken to be garbage
+static const uintptr_t kMaxStackBytes = 64 * 1024 * 1024;
+static const int kDrainMilliseconds = 10;
+
+static const int kSlotFree = 0;
+static const int kSlotWriting = 1;
+static const int kSlotFull = 2;
+
+/****************************************************************
+ * One sample, filled in by the handler and emptied by the thread
+ * that drains the table.
+**/
+struct ProfileSlot
+{
+  std::atomic<int> state;
+  int depth;
+  void* frames[kProfileFrames];
+};
+
+static ProfileSlot slots[kProfileSlots];
+static std::atomic<unsigned> next_slot(0);
+static std::atomic<LONG> samples_taken(0);
+static std::atomic<LONG> samples_dropped(0);
+
+static std::map<std::vector<void*>, LONG> stack_counts;
+static std::mutex drain_mutex;
+static std::condition_variable drain_wake;
+static bool drain_stopping = false;
+static std::thread drain_thread;
+static bool profiling = false;
+
+/****************************************************************
+ * Copy the saved frame pointer and return address at 'frame'
+ * into 'words'. The copy is a system call, so a bad pointer
+ * gives an error instead of a fault in the handler.
+**/
+static bool ReadFrame(uintptr_t frame, uintptr_t words[2])
+{
+  struct iovec local = {words, 2 * sizeof(uintptr_t)};
+  struct iovec remote = {reinterpret_cast<void*>(frame),
+                         2 * sizeof(uintptr_t)};
+  return static_cast<ssize_t>(2 * sizeof(uintptr_t))
+         == process_vm_readv(getpid(), &local, 1, &remote, 1, 0);
+}
+
+/****************************************************************
+ * Walk the interrupted thread's frame pointers from the signal
+ * context: the program counter first, then one return address
+ * per frame. Each frame must be above the last, aligned, and
+ * not far above the stack pointer, and a frame that cannot be
+ * read ends the walk. Returns the number of frames kept.
+**/
+static int WalkFrames(void* context, void* frames[kProfileFrames])
+{
+  ucontext_t* uc = static_cast<ucontext_t*>(context);
+#if defined(__x86_64__)
+  uintptr_t pc = uc->uc_mcontext.gregs[REG_RIP];
+  uintptr_t frame = uc->uc_mcontext.gregs[REG_RBP];
+  uintptr_t stack = uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+  uintptr_t pc = uc->uc_mcontext.pc;
+  uintptr_t frame = uc->uc_mcontext.regs[29];
+  uintptr_t stack = uc->uc_mcontext.sp;
+#else
+  // No way to walk frames here, so samples are empty
+  (void)uc;
+  (void)frames;
+  return 0;
+#endif
+#if defined(__x86_64__) || defined(__aarch64__)
+  int depth = 0;
+  frames[depth++] = reinterpret_cast<void*>(pc);
+  while(depth < kProfileFrames)
+  {
+    if((frame < stack) || (frame - stack > kMaxStackBytes) ||
+       (0 != frame % sizeof(uintptr_t)))
+      break;
+    uintptr_t words[2];
+    if(!ReadFrame(frame, words) || (0 == words[1])) break;
+    frames[depth++] = reinterpret_cast<void*>(words[1]);
+    if(words[0] <= frame) break;
+    frame = words[0];
+  }
+  return depth;
+#endif
+}
+
+/****************************************************************
+ * The SIGPROF handler. It only claims a slot and walks the
+ * interrupted stack into it.
+**/
+static void TakeSample(int, siginfo_t*, void* context)
+{
+  int saved_errno = errno;
+  unsigned start = next_slot.fetch_add(1, std::memory_order_relaxed);
+  for(int probe = 0; probe < kProfileSlots; ++probe)
+  {
+    ProfileSlot& slot = slots[(start + probe) % kProfileSlots];
+    int expected = kSlotFree;
+    if(slot.state.compare_exchange_strong(expected, kSlotWriting,
+                                          std::memory_order_acquire))
+    {
+      slot.depth = WalkFrames(context, slot.frames);
+      slot.state.store(kSlotFull, std::memory_order_release);
+      samples_taken.fetch_add(1, std::memory_order_relaxed);
+      errno = saved_errno;
+      return;
+    }
+  }
+  samples_dropped.fetch_add(1, std::memory_order_relaxed);
+  errno = saved_errno;
+}
+
+/****************************************************************
+ * Move every full slot into 'stack_counts' and free it.
+**/
+static void DrainSlots()
+{
+  for(int sub = 0; sub < kProfileSlots; ++sub)
+  {
+    ProfileSlot& slot = slots[sub];
+    if(kSlotFull != slot.state.load(std::memory_order_acquire)) continue;
+    if(slot.depth > 0)
+    {
+      std::vector<void*> stack(slot.frames, slot.frames + slot.depth);
+      ++stack_counts[stack];
+    }
+    slot.state.store(kSlotFree, std::memory_order_release);
+  }
+}
+
+static void RunDrain()
+{
+  std::unique_lock<std::mutex> lock(drain_mutex);
+  while(!drain_stopping)
+  {
+    drain_wake.wait_for(lock,
+                        std::chrono::milliseconds(kDrainMilliseconds));
+    DrainSlots();
+  }
+}
+
+/****************************************************************
+ * A demangled name without its parameter lists, template
+ * arguments or return type, which folded stacks do not need.
+ * '(anonymous namespace)' is kept.
+**/
+static std::string ShortName(const char* symbol)
+{
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(symbol, nullptr, nullptr, &status);
+  std::string name = (0 == status && nullptr != demangled) ? demangled
+                                                           : symbol;
+  free(demangled);
+
+  static const std::string kAnonymous = "(anonymous namespace)";
+  std::string short_name = "";
+  int nesting = 0;
+  for(std::string::size_type pos = 0; pos < name.length(); ++pos)
+  {
+    if(0 == name.compare(pos, kAnonymous.length(), kAnonymous))
+    {
+      if(0 == nesting) short_name += kAnonymous;
+      pos += kAnonymous.length() - 1;
+      continue;
+    }
+    if(('(' == name[pos]) || ('<' == name[pos])) ++nesting;
+    if(0 == nesting)
+    {
+      // A space at the outer level ends a return type
+      if(' ' == name[pos])
+        short_name = "";
+      else
+        short_name += name[pos];
+    }
+    if(((')' == name[pos]) || ('>' == name[pos])) && (nesting > 0))
+      --nesting;
+  }
+  if(short_name.empty()) short_name = name;
+  std::replace(short_name.begin(), short_name.end(), ';', ':');
+  std::replace(short_name.begin(), short_name.end(), ' ', '_');
+  return short_name;
+}
+
+/****************************************************************
+ * The name of the function an address is in. Return addresses
+ * point after their call, so all but the innermost frame are
+ * looked up one byte back.
+**/
+static std::string FrameName(void* address, bool innermost)
+{
+  char* lookup = static_cast<char*>(address) - (innermost ? 0 : 1);
+  Dl_info info;
+  if((0 != dladdr(lookup, &info)) && (nullptr != info.dli_sname))
+    return ShortName(info.dli_sname);
+
+  char hex[32];
+  if((0 != dladdr(lookup, &info)) && (nullptr != info.dli_fname))
+  {
+    const char* base = strrchr(info.dli_fname, '/');
+    base = (nullptr == base) ? info.dli_fname : base + 1;
+    snprintf(hex, sizeof(hex), "+0x%lx", static_cast<unsigned long>(
+             lookup - static_cast<char*>(info.dli_fbase)));
+    return std::string(base) + hex;
+  }
+  snprintf(hex, sizeof(hex), "0x%lx",
+           reinterpret_cast<unsigned long>(lookup));
+  return std::string(hex);
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Start sampling at 'hz' samples per CPU second.
+**/
+void Profiler::Start(int hz) {
+  if(hz <= 0) hz = 1;
+
+  drain_stopping = false;
+  drain_thread = std::thread(RunDrain);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_sigaction = TakeSample;
+  action.sa_flags = SA_RESTART | SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, nullptr);
+
+  struct itimerval interval;
+  int period_us = std::max(1, 1000000 / hz);
+  interval.it_interval.tv_sec = period_us / 1000000;
+  interval.it_interval.tv_usec = period_us % 1000000;
+  interval.it_value = interval.it_interval;
+  setitimer(ITIMER_PROF, &interval, nullptr);
+  profiling = true;
+}
+
+/****************************************************************
+ * Stop the timer, then the draining thread, and drain the last
+ * samples.
+**/
+void Profiler::Stop() {
+  if(!profiling) return;
+  struct itimerval interval;
+  memset(&interval, 0, sizeof(interval));
+  setitimer(ITIMER_PROF, &interval, nullptr);
+  signal(SIGPROF, SIG_IGN);
+
+  {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    drain_stopping = true;
+  }
+  drain_wake.notify_all();
+  drain_thread.join();
+  DrainSlots();
+  profiling = false;
+}
+
+/****************************************************************
+ * Write the samples as folded stacks, one line per distinct
+ * stack of names, in name order.
+ *
+ * Returns:
+ *   a line saying how many samples and stacks were written
+**/
+std::string Profiler::Write(const std::string& filename) {
+  std::map<void*, std::string> names;
+  std::map<std::string, LONG> folded;
+  for(auto iter = stack_counts.begin(); iter != stack_counts.end(); ++iter)
+  {
+    const std::vector<void*>& stack = iter->first;
+    std::string line = "";
+    for(int frame = static_cast<int>(stack.size()) - 1; frame >= 0; --frame)
+    {
+      auto found = names.find(stack[frame]);
+      if(found == names.end())
+        found = names.insert(std::make_pair(stack[frame],
+                             FrameName(stack[frame], 0 == frame))).first;
+      if(!line.empty()) line += ";";
+      line += found->second;
+    }
+    folded[line] += iter->second;
+  }
+
+  std::ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  for(auto iter = folded.begin(); iter != folded.end(); ++iter)
+  {
+    out_stream << iter->first << " " << iter->second << "\n";
+  }
+  Utils::FileClose(out_stream);
+
+  return "wrote " + std::to_string(samples_taken.load()) + " samples in "
+         + std::to_string(folded.size()) + " stacks to '" + filename
+         + "' (" + std::to_string(samples_dropped.load()) + " dropped)\n";
+}
@@ -0,0 +1,51 @@
+/****************************************************************
+ * Header for the 'Profiler' class.
+ *
+ * 'Profiler' is a sampling profiler for when perf cannot be
+ * installed. 'Start' sets an ITIMER_PROF interval timer, so the
+ * kernel sends SIGPROF each time the process has used another
+ * 1/hz seconds of CPU, to whichever of its threads was running.
+ * The handler walks that thread's frame pointers from the signal
+ * context and puts the stack in a free slot of a fixed table,
+ * claimed with a compare and swap. A sample that finds no free
+ * slot is dropped and counted. The handler does not allocate,
+ * lock or call the unwinder (glibc 'backtrace' takes the loader
+ * lock, so a signal that lands in 'dladdr', 'dlopen' or an
+ * exception unwind could deadlock). Each frame is copied with
+ * 'process_vm_readv', which returns an error rather than faults
+ * on a bad pointer.
+ *
+ * The walk needs frame pointers, so the programs are built with
+ * -fno-omit-frame-pointer. Code built without them (libc,
+ * libstdc++) loses its own frame and sometimes ends the walk
+ * early, and a sample taken at a function's first instruction
+ * misses its caller. Off x86-64 and AArch64 nothing is sampled.
+ *
+ * A thread empties the table every few milliseconds into a map
+ * from stack to count. 'Write' names the frames with 'dladdr'
+ * (link with -rdynamic so static and member functions have
+ * names) and writes one line per stack, outermost frame first,
+ *   main;Simulation::RunSimulation;OnePct::RunSimulationPct 42
+ * the folded format that flamegraph.pl, speedscope and Perfetto
+ * read.
+**/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+
+#include "utils.h"
+
+class Profiler {
+public:
+/****************************************************************
+ * General functions.
+**/
+ static void Start(int hz);
+ static void Stop();
+ // Returns a line for the report, saying what was written
+ static std::string Write(const std::string& filename);
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,173 @@
+#include "quantilesketch.h"
+
+/****************************************************************
+ * Constructor.
+**/
+QuantileSketch::QuantileSketch() {
+}
+
+/****************************************************************
+ * Constructor with a given precision.
+ *
+ * Parameters:
+ *   sub_bucket_bits - values below 2^sub_bucket_bits are exact
+**/
+QuantileSketch::QuantileSketch(int sub_bucket_bits) {
+  assert(sub_bucket_bits >= 1);
+  sub_bucket_bits_ = sub_bucket_bits;
+}
+
+/****************************************************************
+ * Destructor.
+**/
+QuantileSketch::~QuantileSketch() {
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+LONG QuantileSketch::GetCount() const {
+  return count_;
+}
+
+LONG QuantileSketch::GetMax() const {
+  return max_value_;
+}
+
+LONG QuantileSketch::GetMin() const {
+  return min_value_;
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Add one value. Negative values are counted as zero.
+ *
+ * Parameters:
+ *   value - the value to add
+ * Return: none
+**/
+void QuantileSketch::Add(LONG value) {
+  if(value < 0) value = 0;
+
+  int index = this->BucketIndex(value);
+  if(index >= static_cast<int>(counts_.size())) counts_.resize(index + 1, 0);
+  ++counts_[index];
+
+  if((0 == count_) || (value < min_value_)) min_value_ = value;
+  if((0 == count_) || (value > max_value_)) max_value_ = value;
+  ++count_;
+}
+
+/****************************************************************
+ * Empty the sketch.
+**/
+void QuantileSketch::Clear() {
+  count_ = 0;
+  min_value_ = 0;
+  max_value_ = 0;
+  counts_.assign(counts_.size(), 0);
+}
+
+/****************************************************************
+ * Return true if nothing has been added.
+**/
+bool QuantileSketch::IsEmpty() const {
+  return 0 == count_;
+}
+
+/****************************************************************
+ * Merge another sketch with the same precision into this one.
+ *
+ * Parameters:
+ *   other - the sketch to merge in
+ * Return: none
+**/
+void QuantileSketch::Merge(const QuantileSketch& other) {
+  assert(other.sub_bucket_bits_ == sub_bucket_bits_);
+  if(other.IsEmpty()) return;
+
+  if(other.counts_.size() > counts_.size())
+    counts_.resize(other.counts_.size(), 0);
+  for(UINT index = 0; index < other.counts_.size(); ++index)
+  {
+    counts_[index] += other.counts_[index];
+  }
+
+  if(this->IsEmpty() || (other.min_value_ < min_value_))
+    min_value_ = other.min_value_;
+  if(this->IsEmpty() || (other.max_value_ > max_value_))
+    max_value_ = other.max_value_;
+  count_ += other.count_;
+}
+
+/****************************************************************
+ * Return the value at the given fraction of the way through the
+ * sorted values, e.g. 0.5 for the median.
+ *
+ * This is the smallest value v such that at least 'fraction' of
+ * the values are <= v, reported as the highest value its bucket
+ * can hold (but never more than the largest value added).
+ *
+ * Parameters:
+ *   fraction - between 0.0 and 1.0
+ * Returns:
+ *   the quantile, or 0 if the sketch is empty
+**/
+LONG QuantileSketch::Quantile(double fraction) const {
+  if(this->IsEmpty()) return 0;
+
+  LONG rank = static_cast<LONG>(fraction * static_cast<double>(count_));
+  if(static_cast<double>(rank) < fraction * static_cast<double>(count_))
+    ++rank;
+  if(rank < 1) rank = 1;
+  if(rank > count_) rank = count_;
+
+  LONG seen = 0;
+  for(UINT index = 0; index < counts_.size(); ++index)
+  {
+    seen += counts_[index];
+    if(seen >= rank)
+    {
+      LONG value = this->BucketHighest(index);
+      if(value > max_value_) value = max_value_;
+      if(value < min_value_) value = min_value_;
+      return value;
+    }
+  }
+
+  return max_value_;
+}
+
+/****************************************************************
+ * Bucket for a value. Values below 2^bits are their own bucket.
+ * A larger value with highest bit 'top_bit' is shifted right by
+ * (top_bit - bits + 1), which leaves it in [2^(bits-1), 2^bits),
+ * and each shift gets its own block of 2^(bits-1) buckets.
+**/
+int QuantileSketch::BucketIndex(LONG value) const {
+  LONG exact_limit = static_cast<LONG>(1) << sub_bucket_bits_;
+  if(value < exact_limit) return static_cast<int>(value);
+
+  int top_bit = 0;
+  while((value >> (top_bit + 1)) != 0) ++top_bit;
+
+  int shift = top_bit - sub_bucket_bits_ + 1;
+  LONG half = exact_limit / 2;
+  LONG sub_bucket = (value >> shift) - half;
+  return static_cast<int>(exact_limit + (shift - 1) * half + sub_bucket);
+}
+
+/****************************************************************
+ * The highest value that falls in a bucket.
+**/
+LONG QuantileSketch::BucketHighest(int index) const {
+  LONG exact_limit = static_cast<LONG>(1) << sub_bucket_bits_;
+  if(index < exact_limit) return index;
+
+  LONG half = exact_limit / 2;
+  int shift = static_cast<int>((index - exact_limit) / half) + 1;
+  LONG top = (index - exact_limit) % half + half;
+  return ((top + 1) << shift) - 1;
+}
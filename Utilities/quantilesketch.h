@@ -0,0 +1,62 @@
+/****************************************************************
+ * Header for the 'QuantileSketch' class.
+ *
+ * A 'QuantileSketch' is a log-linear (HDR) histogram of
+ * nonnegative integer values. Values below 2^sub_bucket_bits
+ * each get their own bucket. Above that, every power of two is
+ * split into 2^(sub_bucket_bits-1) equal buckets, so a quantile
+ * is never off by more than 1 part in 2^(sub_bucket_bits-1) of
+ * its value (under 1.6% with the default of 7 bits).
+ *
+ * The number of buckets depends only on the largest value, not
+ * on how many values are added, and sketches with the same bits
+ * merge by adding bucket counts. So one sketch can summarize any
+ * number of iterations or precincts in bounded memory.
+**/
+
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <vector>
+
+#include "utils.h"
+
+static const int kDefaultSubBucketBits = 7;
+
+class QuantileSketch {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ QuantileSketch();
+ QuantileSketch(int sub_bucket_bits);
+ virtual ~QuantileSketch();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ LONG GetCount() const;
+ LONG GetMax() const;
+ LONG GetMin() const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Add(LONG value);
+ void Clear();
+ bool IsEmpty() const;
+ void Merge(const QuantileSketch& other);
+ LONG Quantile(double fraction) const;
+
+private:
+ int sub_bucket_bits_ = kDefaultSubBucketBits;
+ LONG count_ = 0;
+ LONG min_value_ = 0;
+ LONG max_value_ = 0;
+ std::vector<LONG> counts_;
+
+ int BucketIndex(LONG value) const;
+ LONG BucketHighest(int index) const;
+};
+
+#endif // QUANTILESKETCH_H
@@ -0,0 +1,67 @@
+#include "reportsink.h"
+
+/****************************************************************
+ * Constructor.
+**/
+ReportSink::ReportSink() {
+}
+
+/****************************************************************
+ * Constructor with the verbosity of each destination.
+**/
+ReportSink::ReportSink(int out_verbosity, int log_verbosity) {
+  out_verbosity_ = out_verbosity;
+  log_verbosity_ = log_verbosity;
+}
+
+/****************************************************************
+ * Destructor.
+**/
+ReportSink::~ReportSink() {
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+const std::string& ReportSink::GetLogText() const {
+  if(this->IsShared()) return out_text_;
+  return log_text_;
+}
+
+const std::string& ReportSink::GetOutText() const {
+  return out_text_;
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Empty both texts but keep the verbosities.
+**/
+void ReportSink::Clear() {
+  out_text_.clear();
+  log_text_.clear();
+}
+
+/****************************************************************
+ * True if the two destinations get the same text.
+**/
+bool ReportSink::IsShared() const {
+  return out_verbosity_ == log_verbosity_;
+}
+
+/****************************************************************
+ * True if either destination takes lines of 'level'.
+**/
+bool ReportSink::Wants(int level) const {
+  return (level <= out_verbosity_) || (level <= log_verbosity_);
+}
+
+/****************************************************************
+ * Add formatted text to the destinations that take 'level'.
+**/
+void ReportSink::Add(int level, const std::string& text) {
+  if(level <= out_verbosity_) out_text_.append(text);
+  if(this->IsShared()) return;
+  if(level <= log_verbosity_) log_text_.append(text);
+}
@@ -0,0 +1,69 @@
+/****************************************************************
+ * Header for the 'ReportSink' class.
+ *
+ * A 'ReportSink' collects the report text for two destinations,
+ * the output file and the log, each with its own verbosity. A
+ * line is given a level and a function that formats it, and is
+ * formatted only if at least one destination wants that level,
+ * so a level nobody wants costs one comparison.
+ *
+ * Levels are small integers, with lower levels the more
+ * important; a destination with verbosity V takes the lines of
+ * level V and below. When both have the same verbosity the text
+ * is kept once and is the same for both.
+**/
+
+#ifndef REPORTSINK_H
+#define REPORTSINK_H
+
+#include <string>
+
+#include "formatter.h"
+#include "utils.h"
+
+class ReportSink {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ ReportSink();
+ ReportSink(int out_verbosity, int log_verbosity);
+ virtual ~ReportSink();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ const std::string& GetLogText() const;
+ const std::string& GetOutText() const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Clear();
+ bool IsShared() const;
+ bool Wants(int level) const;
+
+/****************************************************************
+ * Format a line of 'level' by calling 'format(line)' with an
+ * empty 'Formatter', but only if some destination wants it.
+**/
+ template <typename Format>
+ void Emit(int level, Format format)
+ {
+   if(!this->Wants(level)) return;
+   line_.Clear();
+   format(line_);
+   this->Add(level, line_.GetString());
+ }
+
+private:
+ int out_verbosity_ = 0;
+ int log_verbosity_ = 0;
+ std::string out_text_;
+ std::string log_text_;
+ Formatter line_;
+
+ void Add(int level, const std::string& text);
+};
+
+#endif // REPORTSINK_H
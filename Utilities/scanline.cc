@@ -30,72 +30,28 @@ ScanLine::~ScanLine() {
  * Function 'HasMoreData'.
  *
  * Returns:
- *   true if there are ANY more characters in the input 'string'
+ *   true if there are any more tokens in the input 'string'
 **/
 bool ScanLine::HasMoreData() {
-  bool return_value = true;
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter HasMoreData" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  if(scanline_ss_.eof())
-  {
-    return_value = false;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave HasMoreData '" << return_value << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return return_value;
+  return tokens_.HasNext();
 } 
 
 /****************************************************************
  * Function 'HasNext'.
  *
  * Returns:
- *   true if there are ANY more characters in the input 'string'
+ *   true if there are any more tokens in the input 'string'
 **/
 bool ScanLine::HasNext() {
-  bool return_value = true;
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter HasNext" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  if(scanline_ss_.eof())
-  {
-    return_value = false;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave HasNext '" << return_value << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return return_value;
+  return tokens_.HasNext();
 } 
 
 /****************************************************************
  * Initialization. This because I can't make constructors work.
 **/
 void ScanLine::OpenString(std::string line) {
-  std::string token;
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter OpenString '" << line << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  scanline_ss_.clear();
-  scanline_ss_.str(line);
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave OpenString" << std::endl;
-  Utils::logStream.flush();
-#endif
+  line_ = line;
+  tokens_.Reset(line_.data(), line_.data() + line_.size());
 } 
 
 /****************************************************************
@@ -109,25 +65,7 @@ void ScanLine::OpenString(std::string line) {
  *   the 'string' versin of the next token
 **/
 string ScanLine::Next() {
-  std::string token;
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter next" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  token = "";
-  if(!scanline_ss_.eof())
-  {
-    scanline_ss_ >> token;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave next '" << token << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return token;
+  return tokens_.Next();
 } 
 
 /****************************************************************
@@ -140,24 +78,7 @@ string ScanLine::Next() {
  *   the next token in the file, parsed as an 'int'
 **/
 double ScanLine::NextDouble() {
-  double local_double = 0.0;
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextDouble" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  if(!scanline_ss_.eof())
-  {
-    scanline_ss_ >> local_double;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextDouble '" << nextValue << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return local_double;
+  return tokens_.NextDouble();
 } 
 
 /****************************************************************
@@ -170,66 +91,20 @@ double ScanLine::NextDouble() {
  *   the next token in the file, parsed as an 'int'
 **/
 int ScanLine::NextInt() {
-  int next_value = 0;
-  std::string token = "";
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextInt" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  if(!scanline_ss_.eof())
-  {
-    scanline_ss_ >> token;
-    next_value = Utils::StringToInteger(token); 
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextInt '" << NextValue << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return next_value;
+  return tokens_.NextInt();
 } 
 
 /****************************************************************
  * Function 'NextLine' to return the rest of the line.
  *
- * This is just a wrapper for the 'getline' function.
  * Note that this does not trim whitespace at the beginning
  * or at the end.
  *
- * CAVEAT: We have put a max of 1024 characters that can be
- *         parsed with this function.
- *
  * Returns:
  *   the 'string' version of the rest of the line
 **/
 string ScanLine::NextLine() {
-  char xx[1025];
-  std::string token;
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextLine" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  if (scanline_ss_.eof())
-  {
-    token = "";
-  }
-  else
-  {
-    scanline_ss_.getline(xx,1024);
-    token = string(xx);
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextLine '" << token << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return token;
+  return tokens_.NextLine();
 } 
 
 /****************************************************************
@@ -242,26 +117,7 @@ string ScanLine::NextLine() {
  *   the next token in the file, parsed as an 'LONG'
 **/
 LONG ScanLine::NextLONG() {
-  LONG next_value = 0;
-  std::string token = "";
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextLONG" << std::endl;
-  Utils::logStream.flush();
-#endif
-  
-  if(!scanline_ss_.eof())
-  {
-    scanline_ss_ >> token;
-    next_value = Utils::StringToLONG(token); 
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextLONG '" << next_value << "'" << std::endl;
-  Utils::logStream.flush();
-#endif
-
-  return next_value;
+  return tokens_.NextLONG();
 } 
 
 /****************************************************************
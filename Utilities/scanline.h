@@ -6,6 +6,8 @@
  *
  * This code performs the utility function of being a 'Scanner'
  * for a string, analogous to what a 'Scanner' does on a file.
+ *
+ * The string is kept as is and read in place by a 'Tokenizer'.
 **/
 
 #ifndef SCANLINE_H
@@ -22,6 +24,7 @@
 #include <sys/resource.h>
 
 #include "../Utilities/utils.h"
+#include "../Utilities/tokenizer.h"
 // #include "../Utilities/Scanner.h"
 
 #define NDEBUG
@@ -41,12 +44,12 @@ public:
 //  static stringstream zorkss;
 //  static ostringstream zorkoss;
 
- std::stringstream scanline_ss_;
-
 /****************************************************************
  * Constructors and destructors for the class. 
 **/
  ScanLine();
+ ScanLine(const ScanLine&) = delete;
+ ScanLine& operator=(const ScanLine&) = delete;
  virtual ~ScanLine();
 
 /****************************************************************
@@ -62,7 +65,8 @@ public:
  std::string NextLine();
 
 private:
-
+ std::string line_;
+ Tokenizer tokens_;
 };
 
 #endif // SCANLINE_H
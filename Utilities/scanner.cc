@@ -26,6 +26,7 @@ Scanner::~Scanner() {
  * Function to close the stream.
 **/
 void Scanner::Close() {
+  mapped_file_.Close();
   Utils::FileClose(local_stream_);
 }
 
@@ -38,6 +39,10 @@ void Scanner::Close() {
 bool Scanner::HasNext() {
   bool return_value = true;
 
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.HasNext();
+  }
+
 //  std::cout << TAG << "enter HasNext" << std::endl;
 
   if (scanline_.HasNext()) {
@@ -107,6 +112,9 @@ bool Scanner::HasNext() {
 **/
 
 std::string Scanner::Next() {
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.Next();
+  }
 
   std::string return_value = scanline_.Next();
 
@@ -138,6 +146,10 @@ char Scanner::nextChar()
 double Scanner::NextDouble() {
   double return_value;
 
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.NextDouble();
+  }
+
   std::string next_token = this->Next();
   return_value = atof(next_token.c_str());
 
@@ -159,6 +171,9 @@ int Scanner::NextInt() {
   std::string next_token;
 
   return_value = 0;
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.NextInt();
+  }
   next_token = this->Next();
 
   return_value = Utils::StringToInteger(next_token);
@@ -180,6 +195,10 @@ int Scanner::NextInt() {
 std::string Scanner::NextLine() {
   std::string return_value;
 
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.NextLine();
+  }
+
 //  std::cout << TAG << "enter NextLine" << std::endl;
 
   if (scanline_.HasNext())
@@ -212,6 +231,9 @@ LONG Scanner::NextLONG() {
   std::string next_token;
 
   return_value = 0;
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.NextLONG();
+  }
   next_token = this->Next();
 
   return_value = Utils::StringToLONG(next_token);
@@ -219,11 +241,40 @@ LONG Scanner::NextLONG() {
   return return_value;
 } // LONG Scanner::NextLONG()
 
+/****************************************************************
+ * Function for returning the next token without copying it.
+ *
+ * For a mapped file the view points into the file and stays
+ * good until 'Close'. Otherwise it points into a copy that only
+ * lasts until the next call.
+ *
+ * Returns:
+ *   a view of the next token in the file
+**/
+
+std::string_view Scanner::NextView() {
+  if (mapped_file_.IsOpen()) {
+    return mapped_tokens_.NextView();
+  }
+
+  next_view_copy_ = this->Next();
+  return std::string_view(next_view_copy_);
+} // string_view Scanner::NextView()
+
 /****************************************************************
  * Function to open a file as a 'Scanner'.
+ *
+ * A regular file is mapped. Anything else is opened as a stream.
 **/
 
 void Scanner::OpenFile(std::string filename) {
+  if (mapped_file_.Open(filename)) {
+    std::cout << kTag << "mapped the input file '" << filename << "'\n";
+    mapped_tokens_.Reset(mapped_file_.GetData(),
+                         mapped_file_.GetData() + mapped_file_.GetSize());
+    return;
+  }
+
   Utils::FileOpen(local_stream_, filename);
 }
 
@@ -4,6 +4,10 @@
  * Author/copyright:  Duncan Buell
  * Date: 8 May 2016
  *
+ * A regular file is mapped into memory and read in place by a
+ * 'Tokenizer'. Anything that cannot be mapped, such as a pipe,
+ * is read line by line through 'local_stream_' and a 'ScanLine'.
+ * Both give the same tokens and lines.
 **/
 
 #ifndef SCANNER_H_
@@ -16,7 +20,9 @@
 #include <vector>
 
 #include "utils.h"
+#include "mappedfile.h"
 #include "scanline.h"
+#include "tokenizer.h"
 
 #define NDEBUG
 #include <cassert>
@@ -44,6 +50,7 @@ public:
  double NextDouble();
  std::string Next();
  std::string NextLine();
+ std::string_view NextView();
  void OpenFile(std::string filename);
  int NextInt();
  LONG NextLONG();
@@ -52,6 +59,9 @@ private:
  const std::string kTag = "SCANNER: ";
 
  ScanLine scanline_;
+ MappedFile mapped_file_;
+ Tokenizer mapped_tokens_;
+ std::string next_view_copy_;
 };
 
 #endif // SCANNER_H_
@@ -0,0 +1,562 @@
+#include "scopedtimer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "eventtrace.h"
+#include "allocstats.h"
+#include "formatter.h"
+#include "perfcounters.h"
+
+// The hardware counters, the allocations, then the items counted with
+// CountItems
+static const int kAllocSlot = kPerfCounterCount;
+static const int kItemSlot = kAllocSlot + kAllocCounterCount;
+static const int kCounterSlots = kItemSlot + 1;
+
+/****************************************************************
+ * One label in a thread's hierarchy, and the time spent under it.
+ * Node 0 is the root, above every outermost timer.
+**/
+struct TimerNode
+{
+  const char* label;
+  int parent;
+  LONG total_ns;
+  LONG count;
+  LONG counts[kCounterSlots];
+  std::vector<int> children;
+};
+
+/****************************************************************
+ * The time and counts for one value of a label.
+**/
+struct ValueTotals
+{
+  LONG total_ns;
+  LONG counts[kCounterSlots];
+};
+
+/****************************************************************
+ * A timer that is running on a thread.
+**/
+struct TimerFrame
+{
+  const char* label;
+  LONG value;
+  bool has_value;
+  LONG start_ns;
+  LONG start_counts[kCounterSlots];
+  int node;
+};
+
+/****************************************************************
+ * Everything one thread has timed. 'values' has one entry for
+ * each label that carried a value, the totals for each value.
+ * 'items' is everything the thread has counted with CountItems.
+**/
+struct ThreadTimers
+{
+  std::vector<TimerNode> nodes;
+  std::vector<TimerFrame> stack;
+  std::vector<std::pair<const char*,
+                        std::unordered_map<LONG, ValueTotals> > > values;
+  PerfCounters perf;
+  LONG items;
+};
+
+/****************************************************************
+ * The totals of every thread, merged by 'Report'.
+**/
+struct MergedNode
+{
+  std::string label;
+  LONG total_ns;
+  LONG count;
+  LONG counts[kCounterSlots];
+  std::vector<int> children;
+};
+
+static std::mutex timers_mutex;
+static std::vector<std::unique_ptr<ThreadTimers> > all_timers;
+static thread_local ThreadTimers* thread_timers = nullptr;
+static LONG clock_start_ns = 0;
+static bool perf_enabled = false;
+
+/****************************************************************
+ * Labels are compared by address first; the same literal can
+ * have different addresses in different files.
+**/
+static bool SameLabel(const char* first, const char* second)
+{
+  return (first == second) || (0 == strcmp(first, second));
+}
+
+/****************************************************************
+ * This thread's totals, made and registered on its first timer.
+**/
+static ThreadTimers* GetThreadTimers()
+{
+  if(nullptr == thread_timers)
+  {
+    std::unique_ptr<ThreadTimers> timers(new ThreadTimers());
+    timers->nodes.push_back(TimerNode{"", -1, 0, 0, {}, {}});
+    timers->items = 0;
+    if(perf_enabled) timers->perf.Open();
+    thread_timers = timers.get();
+    std::lock_guard<std::mutex> lock(timers_mutex);
+    all_timers.push_back(std::move(timers));
+  }
+  return thread_timers;
+}
+
+/****************************************************************
+ * The thread's counters now, the hardware ones zero if they are
+ * not open.
+**/
+static void ReadCounts(const ThreadTimers& timers,
+                       LONG counts[kCounterSlots])
+{
+  uint64_t perf_counts[kPerfCounterCount];
+  timers.perf.Read(perf_counts);
+  for(int slot = 0; slot < kPerfCounterCount; ++slot)
+  {
+    counts[slot] = static_cast<LONG>(perf_counts[slot]);
+  }
+  AllocStats::Read(counts + kAllocSlot);
+  counts[kItemSlot] = timers.items;
+}
+
+/****************************************************************
+ * Add a thread's node 'from' and everything under it to the
+ * merged node 'into', matching children by label.
+**/
+static void MergeNode(const ThreadTimers& timers, int from,
+                      std::vector<MergedNode>& merged, int into)
+{
+  merged[into].total_ns += timers.nodes[from].total_ns;
+  merged[into].count += timers.nodes[from].count;
+  for(int slot = 0; slot < kCounterSlots; ++slot)
+  {
+    merged[into].counts[slot] += timers.nodes[from].counts[slot];
+  }
+
+  for(UINT sub = 0; sub < timers.nodes[from].children.size(); ++sub)
+  {
+    int child = timers.nodes[from].children[sub];
+    std::string label = timers.nodes[child].label;
+    int match = -1;
+    for(UINT look = 0; look < merged[into].children.size(); ++look)
+    {
+      if(merged[merged[into].children[look]].label == label)
+        match = merged[into].children[look];
+    }
+    if(match < 0)
+    {
+      match = static_cast<int>(merged.size());
+      merged.push_back(MergedNode{label, 0, 0, {}, {}});
+      merged[into].children.push_back(match);
+    }
+    MergeNode(timers, child, merged, match);
+  }
+}
+
+/****************************************************************
+ * Write a merged node's line and then its children's, longest
+ * first, each level indented two more.
+**/
+static void AppendNode(const std::vector<MergedNode>& merged, int node,
+                       int depth, double wall_ns, Formatter& lines)
+{
+  if(node > 0)
+  {
+    std::string indent(2 * (depth - 1), ' ');
+    lines.Append("TIME ");
+    lines.AppendLeft(indent + merged[node].label, 36);
+    lines.AppendFixed(merged[node].total_ns / 1.0e9, 14, 6);
+    lines.AppendInt(merged[node].count, 11);
+    lines.AppendFixed(100.0 * merged[node].total_ns / wall_ns, 10, 2);
+    lines.Append("\n");
+  }
+
+  std::vector<int> children = merged[node].children;
+  std::sort(children.begin(), children.end(), [&merged](int a, int b) {
+    return merged[a].total_ns > merged[b].total_ns;
+  });
+  for(UINT sub = 0; sub < children.size(); ++sub)
+  {
+    AppendNode(merged, children[sub], depth + 1, wall_ns, lines);
+  }
+}
+
+/****************************************************************
+ * Per one item, or zero if there were no items.
+**/
+static double PerItem(LONG count, LONG items)
+{
+  if(items <= 0) return 0.0;
+  return static_cast<double>(count) / items;
+}
+
+/****************************************************************
+ * Instructions per cycle, or zero if no cycles were counted.
+**/
+static double Ipc(const LONG counts[kCounterSlots])
+{
+  if(counts[kPerfCycles] <= 0) return 0.0;
+  return static_cast<double>(counts[kPerfInstructions])
+         / counts[kPerfCycles];
+}
+
+/****************************************************************
+ * The counters of a merged node and then its children's, in the
+ * same order as 'AppendNode': the hardware counters, or with
+ * 'allocations' the allocations. Misses and allocations are per
+ * item; a node that counted no items of its own uses the items
+ * of the node above.
+**/
+static void AppendCounters(const std::vector<MergedNode>& merged,
+                           int node, int depth, LONG items,
+                           bool allocations, Formatter& lines)
+{
+  if(merged[node].counts[kItemSlot] > 0)
+    items = merged[node].counts[kItemSlot];
+
+  if(node > 0)
+  {
+    const LONG* counts = merged[node].counts;
+    std::string indent(2 * (depth - 1), ' ');
+    lines.Append("TIME ");
+    lines.AppendLeft(indent + merged[node].label, 36);
+    if(allocations)
+    {
+      LONG calls = counts[kAllocSlot + kAllocCalls];
+      LONG bytes = counts[kAllocSlot + kAllocBytes];
+      lines.AppendInt(calls, 12);
+      lines.AppendFixed(bytes / 1048576.0, 12, 3);
+      lines.AppendInt(items, 12);
+      lines.AppendFixed(PerItem(calls, items), 12, 3);
+      lines.AppendFixed(PerItem(bytes, items), 12, 1);
+    }
+    else
+    {
+      lines.AppendFixed(counts[kPerfCycles] / 1.0e9, 10, 3);
+      lines.AppendFixed(Ipc(counts), 7, 2);
+      lines.AppendInt(items, 12);
+      lines.AppendFixed(PerItem(counts[kPerfBranchMisses], items), 11, 2);
+      lines.AppendFixed(PerItem(counts[kPerfL1dMisses], items), 11, 2);
+      lines.AppendFixed(PerItem(counts[kPerfLlcMisses], items), 11, 2);
+    }
+    lines.Append("\n");
+  }
+
+  std::vector<int> children = merged[node].children;
+  std::sort(children.begin(), children.end(), [&merged](int a, int b) {
+    return merged[a].total_ns > merged[b].total_ns;
+  });
+  for(UINT sub = 0; sub < children.size(); ++sub)
+  {
+    AppendCounters(merged, children[sub], depth + 1, items, allocations,
+                   lines);
+  }
+}
+
+/****************************************************************
+ * Constructor for a timer with just a label.
+**/
+ScopedTimer::ScopedTimer(const char* label) {
+  this->Open(label, 0, false);
+}
+
+/****************************************************************
+ * Constructor for a timer whose label carries a value.
+**/
+ScopedTimer::ScopedTimer(const char* label, LONG value) {
+  this->Open(label, value, true);
+}
+
+/****************************************************************
+ * Destructor. Stops the timer and adds its time to its node and
+ * to its value.
+**/
+ScopedTimer::~ScopedTimer() {
+  LONG now_ns = NowNanoseconds();
+  ThreadTimers* timers = thread_timers;
+  LONG now_counts[kCounterSlots];
+  ReadCounts(*timers, now_counts);
+  const TimerFrame& frame = timers->stack.back();
+
+  LONG elapsed_ns = now_ns - frame.start_ns;
+  TimerNode& node = timers->nodes[frame.node];
+  node.total_ns += elapsed_ns;
+  ++node.count;
+  for(int slot = 0; slot < kCounterSlots; ++slot)
+  {
+    node.counts[slot] += now_counts[slot] - frame.start_counts[slot];
+  }
+
+  if(frame.has_value)
+  {
+    UINT sub = 0;
+    while((sub < timers->values.size()) &&
+          !SameLabel(timers->values[sub].first, frame.label))
+      ++sub;
+    if(sub == timers->values.size())
+      timers->values.push_back(std::make_pair(frame.label,
+                               std::unordered_map<LONG, ValueTotals>()));
+
+    // A new value starts zeroed
+    ValueTotals& totals = timers->values[sub].second[frame.value];
+    totals.total_ns += elapsed_ns;
+    for(int slot = 0; slot < kCounterSlots; ++slot)
+    {
+      totals.counts[slot] += now_counts[slot] - frame.start_counts[slot];
+    }
+  }
+  EventTrace::AddSpan(frame.label, frame.has_value, frame.value,
+                      frame.start_ns, now_ns);
+  timers->stack.pop_back();
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Count 'count' items, such as voters, under every timer running
+ * on this thread, so the report can give counters per item.
+**/
+void ScopedTimer::CountItems(LONG count) {
+  GetThreadTimers()->items += count;
+}
+
+/****************************************************************
+ * Count hardware events under the timers of every thread that
+ * starts timing after this. Call it before the first timer.
+**/
+void ScopedTimer::EnablePerfCounters() {
+  perf_enabled = true;
+}
+
+/****************************************************************
+ * The monotonic clock, in nanoseconds.
+**/
+LONG ScopedTimer::NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/****************************************************************
+ * The end-of-run report, every line starting 'TIME'.
+ *
+ * Parameters:
+ *   top_count - how many values of each label to list
+ * Returns:
+ *   the report
+**/
+std::string ScopedTimer::Report(const int top_count) {
+  double wall_ns = static_cast<double>(NowNanoseconds() - clock_start_ns);
+  if(wall_ns <= 0.0) wall_ns = 1.0;
+
+  std::vector<MergedNode> merged;
+  merged.push_back(MergedNode{"", 0, 0, {}, {}});
+  std::vector<std::pair<std::string,
+                        std::unordered_map<LONG, ValueTotals> > > values;
+  int perf_threads = 0;
+  std::string perf_error = "";
+  {
+    std::lock_guard<std::mutex> lock(timers_mutex);
+    for(UINT sub = 0; sub < all_timers.size(); ++sub)
+    {
+      const ThreadTimers& timers = *all_timers[sub];
+      MergeNode(timers, 0, merged, 0);
+      if(timers.perf.IsOpen())
+        ++perf_threads;
+      else if(perf_error == "")
+        perf_error = timers.perf.GetError();
+      for(UINT label = 0; label < timers.values.size(); ++label)
+      {
+        std::string name = timers.values[label].first;
+        UINT match = 0;
+        while((match < values.size()) && (values[match].first != name))
+          ++match;
+        if(match == values.size())
+          values.push_back(std::make_pair(name,
+                           std::unordered_map<LONG, ValueTotals>()));
+        for(auto iter = timers.values[label].second.begin();
+            iter != timers.values[label].second.end(); ++iter)
+        {
+          ValueTotals& totals = values[match].second[iter->first];
+          totals.total_ns += iter->second.total_ns;
+          for(int slot = 0; slot < kCounterSlots; ++slot)
+          {
+            totals.counts[slot] += iter->second.counts[slot];
+          }
+        }
+      }
+    }
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double user_seconds = usage.ru_utime.tv_sec
+                        + usage.ru_utime.tv_usec / 1000000.0;
+  double system_seconds = usage.ru_stime.tv_sec
+                          + usage.ru_stime.tv_usec / 1000000.0;
+
+  Formatter lines;
+  lines.Append("\nTIME*********************************************");
+  lines.Append("**************************\n");
+  lines.Append("TIME wall ");
+  lines.AppendFixed(wall_ns / 1.0e9, 12, 6);
+  lines.Append(" s   user ");
+  lines.AppendFixed(user_seconds, 10, 2);
+  lines.Append(" s   system ");
+  lines.AppendFixed(system_seconds, 10, 2);
+  lines.Append(" s   Res:");
+  lines.AppendInt(usage.ru_maxrss, 12);
+  lines.Append("\n");
+  lines.Append("TIME ");
+  lines.AppendLeft("scope (time on all threads)", 36);
+  lines.AppendRight("seconds", 14);
+  lines.AppendRight("calls", 11);
+  lines.AppendRight("% wall", 10);
+  lines.Append("\n");
+  AppendNode(merged, 0, 0, wall_ns, lines);
+
+  if(perf_threads > 0)
+  {
+    lines.Append("TIME ");
+    lines.AppendLeft("scope (counters, misses per voter)", 36);
+    lines.AppendRight("Gcycles", 10);
+    lines.AppendRight("IPC", 7);
+    lines.AppendRight("voters", 12);
+    for(int which = kPerfBranchMisses; which < kPerfCounterCount; ++which)
+    {
+      lines.AppendRight(PerfCounters::GetName(which), 11);
+    }
+    lines.Append("\n");
+    AppendCounters(merged, 0, 0, 0, false, lines);
+  }
+  else if(perf_enabled)
+  {
+    lines.Append("TIME perf counters not available: " + perf_error);
+    lines.Append("\n");
+  }
+
+  if(AllocStats::IsEnabled())
+  {
+    lines.Append("TIME allocations: peak live MB ");
+    lines.AppendFixed(AllocStats::GetPeakLiveBytes() / 1048576.0, 1, 3);
+    lines.Append("   live at end MB ");
+    lines.AppendFixed(AllocStats::GetLiveBytes() / 1048576.0, 1, 3);
+    lines.Append("   Res KB ");
+    lines.AppendInt(usage.ru_maxrss, 1);
+    lines.Append("\n");
+    lines.Append("TIME ");
+    lines.AppendLeft("scope (allocations, per voter)", 36);
+    lines.AppendRight("allocs", 12);
+    lines.AppendRight("MB", 12);
+    lines.AppendRight("voters", 12);
+    lines.AppendRight("allocs/v", 12);
+    lines.AppendRight("bytes/v", 12);
+    lines.Append("\n");
+    AppendCounters(merged, 0, 0, 0, true, lines);
+  }
+
+  for(UINT label = 0; label < values.size(); ++label)
+  {
+    std::vector<std::pair<LONG, LONG> > longest;
+    for(auto iter = values[label].second.begin();
+        iter != values[label].second.end(); ++iter)
+    {
+      longest.push_back(std::make_pair(iter->second.total_ns, iter->first));
+    }
+    int count = std::min(top_count, static_cast<int>(longest.size()));
+    std::partial_sort(longest.begin(), longest.begin() + count,
+                      longest.end(),
+                      [](const std::pair<LONG, LONG>& a,
+                         const std::pair<LONG, LONG>& b) {
+                        if(a.first != b.first) return a.first > b.first;
+                        return a.second < b.second;
+                      });
+
+    lines.Append("TIME longest '" + values[label].first + "' of ");
+    lines.AppendInt(static_cast<LONG>(longest.size()), 1);
+    lines.Append("\n");
+    for(int sub = 0; sub < count; ++sub)
+    {
+      lines.Append("TIME   ");
+      lines.AppendLeft(values[label].first, 12);
+      lines.AppendInt(longest[sub].second, 8);
+      lines.AppendFixed(longest[sub].first / 1.0e9, 14, 6);
+      lines.AppendFixed(100.0 * longest[sub].first / wall_ns, 10, 2);
+      if(perf_threads > 0)
+      {
+        const LONG* counts =
+          values[label].second[longest[sub].second].counts;
+        lines.Append("   IPC");
+        lines.AppendFixed(Ipc(counts), 6, 2);
+        lines.Append("   LLC-miss/voter");
+        lines.AppendFixed(PerItem(counts[kPerfLlcMisses],
+                                  counts[kItemSlot]), 9, 2);
+      }
+      if(AllocStats::IsEnabled())
+      {
+        const LONG* counts =
+          values[label].second[longest[sub].second].counts;
+        lines.Append("   allocs/voter");
+        lines.AppendFixed(PerItem(counts[kAllocSlot + kAllocCalls],
+                                  counts[kItemSlot]), 9, 2);
+      }
+      lines.Append("\n");
+    }
+  }
+
+  lines.Append("TIME*********************************************");
+  lines.Append("**************************\n");
+  return lines.GetString();
+}
+
+/****************************************************************
+ * Start the wall clock the report measures against.
+**/
+void ScopedTimer::StartClock() {
+  clock_start_ns = NowNanoseconds();
+}
+
+/****************************************************************
+ * Push a running timer on this thread, under the timer that is
+ * running now, finding or adding its node.
+**/
+void ScopedTimer::Open(const char* label, LONG value, bool has_value) {
+  ThreadTimers* timers = GetThreadTimers();
+  int parent = 0;
+  if(!timers->stack.empty()) parent = timers->stack.back().node;
+
+  int node = -1;
+  const std::vector<int>& children = timers->nodes[parent].children;
+  for(UINT sub = 0; sub < children.size(); ++sub)
+  {
+    if(SameLabel(timers->nodes[children[sub]].label, label))
+    {
+      node = children[sub];
+      break;
+    }
+  }
+  if(node < 0)
+  {
+    node = static_cast<int>(timers->nodes.size());
+    timers->nodes.push_back(TimerNode{label, parent, 0, 0, {}});
+    timers->nodes[parent].children.push_back(node);
+  }
+
+  timers->stack.push_back(TimerFrame{label, value, has_value, 0, {}, node});
+  TimerFrame& frame = timers->stack.back();
+  ReadCounts(*timers, frame.start_counts);
+  frame.start_ns = NowNanoseconds();
+}
@@ -0,0 +1,73 @@
+/****************************************************************
+ * Header for the 'ScopedTimer' class.
+ *
+ * A 'ScopedTimer' times the block it is declared in, from the
+ * monotonic clock in nanoseconds, and adds the time under its
+ * label when the block ends. Timers opened inside it are nested
+ * under it, so the labels make a hierarchy, e.g.
+ *   pct / stations / iteration / CreateVoters
+ * A label can carry a value, such as the precinct number, and
+ * the time for each value of a label is kept as well.
+ *
+ * Each thread keeps its own totals, with no locking, and
+ * nothing is allocated once a thread has seen its labels. The
+ * hierarchy is kept by label only, without the values, so it
+ * stays small however many precincts are run; the values are
+ * only kept one label at a time.
+ *
+ * 'Report' merges every thread's totals into the end-of-run
+ * report: the hierarchy with its times and counts, the values
+ * of each label that took the longest, and the process's CPU
+ * time and memory. Call it only when no timed thread is running.
+ *
+ * With 'EnablePerfCounters' each thread also opens a group of
+ * hardware counters (see 'PerfCounters') and every timer adds
+ * the cycles, instructions and misses it ran over, so the report
+ * has IPC and misses per voter for each scope. Voters are what
+ * the code counts with 'CountItems'. If the counters cannot be
+ * opened the report says why and is otherwise as before.
+ *
+ * With 'AllocStats' enabled every timer also adds the thread's
+ * allocations under it, and the report has allocations and bytes
+ * per voter for each scope, and the peak live bytes.
+ *
+ * Once 'EventTrace' is enabled every timer is also recorded as a
+ * span on its thread's timeline.
+ *
+ * The labels must be string literals, or at least outlive the
+ * program's timers.
+**/
+
+#ifndef SCOPEDTIMER_H
+#define SCOPEDTIMER_H
+
+#include <string>
+
+#include "utils.h"
+
+class ScopedTimer
+{
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ explicit ScopedTimer(const char* label);
+ ScopedTimer(const char* label, LONG value);
+ ScopedTimer(const ScopedTimer&) = delete;
+ ScopedTimer& operator=(const ScopedTimer&) = delete;
+ virtual ~ScopedTimer();
+
+/****************************************************************
+ * General functions.
+**/
+ static void CountItems(LONG count);
+ static void EnablePerfCounters();
+ static LONG NowNanoseconds();
+ static std::string Report(const int top_count);
+ static void StartClock();
+
+private:
+ void Open(const char* label, LONG value, bool has_value);
+};
+
+#endif // SCOPEDTIMER_H
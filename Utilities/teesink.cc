@@ -0,0 +1,271 @@
+#include "teesink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static const std::string kTag = "TEESINK: ";
+
+// Ask for pipes this big, so a typical batch of output fits in one
+static const int kPipeBytes = 1024 * 1024;
+
+/****************************************************************
+ * Constructor.
+**/
+TeeSink::TeeSink() {
+}
+
+/****************************************************************
+ * Destructor.
+**/
+TeeSink::~TeeSink() {
+  this->Close();
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+bool TeeSink::IsOpen() const {
+  return first_fd_ >= 0;
+}
+
+bool TeeSink::IsSplicing() const {
+  return splicing_;
+}
+
+/****************************************************************
+ * True if text for these two streams should come to this sink.
+**/
+bool TeeSink::Matches(const std::ofstream* first_stream,
+                      const std::ofstream* second_stream) const {
+  return this->IsOpen() && (first_stream == first_stream_) &&
+         (second_stream == second_stream_);
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Close the descriptors and pipes, and move each stream to the
+ * end of its file, past what the sink wrote.
+**/
+void TeeSink::Close() {
+  if(!this->IsOpen()) return;
+
+  close(first_fd_);
+  close(second_fd_);
+  first_fd_ = -1;
+  second_fd_ = -1;
+  for(int end = 0; end < 2; ++end)
+  {
+    if(first_pipe_[end] >= 0) close(first_pipe_[end]);
+    if(second_pipe_[end] >= 0) close(second_pipe_[end]);
+    first_pipe_[end] = -1;
+    second_pipe_[end] = -1;
+  }
+
+  first_stream_->seekp(0, std::ios::end);
+  second_stream_->seekp(0, std::ios::end);
+  first_stream_ = nullptr;
+  second_stream_ = nullptr;
+  splicing_ = false;
+}
+
+/****************************************************************
+ * Start writing for two open streams.
+ *
+ * Parameters:
+ *   first_stream, second_stream - the streams, already open
+ *   first_filename, second_filename - the files they write
+ * Returns:
+ *   false if the files cannot be opened again for writing, in
+ *   which case the streams should just be used as they are
+**/
+bool TeeSink::Open(std::ofstream* first_stream,
+                   const std::string& first_filename,
+                   std::ofstream* second_stream,
+                   const std::string& second_filename) {
+  assert(!this->IsOpen());
+  first_stream->flush();
+  second_stream->flush();
+
+  first_fd_ = open(first_filename.c_str(), O_WRONLY);
+  second_fd_ = open(second_filename.c_str(), O_WRONLY);
+  if((first_fd_ < 0) || (second_fd_ < 0))
+  {
+    if(first_fd_ >= 0) close(first_fd_);
+    if(second_fd_ >= 0) close(second_fd_);
+    first_fd_ = -1;
+    second_fd_ = -1;
+    return false;
+  }
+  lseek(first_fd_, 0, SEEK_END);
+  lseek(second_fd_, 0, SEEK_END);
+  first_stream_ = first_stream;
+  second_stream_ = second_stream;
+
+#ifdef __linux__
+  splicing_ = (0 == pipe(first_pipe_)) && (0 == pipe(second_pipe_));
+  if(splicing_)
+  {
+    fcntl(first_pipe_[1], F_SETPIPE_SZ, kPipeBytes);
+    fcntl(second_pipe_[1], F_SETPIPE_SZ, kPipeBytes);
+    int first_size = fcntl(first_pipe_[1], F_GETPIPE_SZ);
+    int second_size = fcntl(second_pipe_[1], F_GETPIPE_SZ);
+    pipe_bytes_ = static_cast<size_t>(std::min(first_size, second_size));
+    splicing_ = (first_size > 0) && (second_size > 0);
+  }
+#endif
+
+  std::cout << kTag << "writing '" << first_filename << "' and '"
+            << second_filename << "' "
+            << (splicing_ ? "with splice and tee" : "with write") << "\n";
+  return true;
+}
+
+/****************************************************************
+ * Write 'size' bytes of 'data' to both files.
+**/
+void TeeSink::Write(const char* data, size_t size) {
+  assert(this->IsOpen());
+  if(splicing_ && this->SpliceWrite(data, size)) return;
+
+  WriteAll(first_fd_, data, size);
+  WriteAll(second_fd_, data, size);
+}
+
+/****************************************************************
+ * Read 'count' bytes back out of a pipe and write them to 'fd'.
+ * Used when splicing stops part way through.
+**/
+void TeeSink::DrainPipe(int pipe_fd, size_t count, int fd) {
+  char buffer[64 * 1024];
+  while(count > 0)
+  {
+    size_t want = std::min(count, sizeof(buffer));
+    ssize_t got = read(pipe_fd, buffer, want);
+    if(got < 0 && EINTR == errno) continue;
+    if(got <= 0) break;
+    WriteAll(fd, buffer, static_cast<size_t>(got));
+    count -= static_cast<size_t>(got);
+  }
+}
+
+/****************************************************************
+ * Say why splicing stopped, once, and stop trying.
+**/
+void TeeSink::GiveUpSplicing(const std::string& call) {
+  std::cout << kTag << call << " failed (" << strerror(errno)
+            << "), writing both files with write\n";
+  splicing_ = false;
+}
+
+/****************************************************************
+ * Write through the pipes, one pipeful at a time:
+ *   vmsplice  the text into the first pipe
+ *   tee       the first pipe into the second, leaving both full
+ *   splice    each pipe into its file
+ * Returns false, having written nothing, if the very first
+ * vmsplice fails. A failure after that finishes the chunk it was
+ * in with plain writes and returns true; either way splicing is
+ * off from then on and the rest goes by 'write'.
+**/
+bool TeeSink::SpliceWrite(const char* data, size_t size) {
+#ifdef __linux__
+  size_t done = 0;
+  while(done < size)
+  {
+    size_t chunk = std::min(size - done, pipe_bytes_);
+    struct iovec piece;
+    piece.iov_base = const_cast<char*>(data + done);
+    piece.iov_len = chunk;
+
+    ssize_t moved = vmsplice(first_pipe_[1], &piece, 1, 0);
+    if(moved <= 0)
+    {
+      if(moved < 0 && EINTR == errno) continue;
+      this->GiveUpSplicing("vmsplice");
+      if(0 == done) return false;
+      WriteAll(first_fd_, data + done, size - done);
+      WriteAll(second_fd_, data + done, size - done);
+      return true;
+    }
+    size_t count = static_cast<size_t>(moved);
+
+    size_t teed = 0;
+    while(teed < count)
+    {
+      ssize_t got = tee(first_pipe_[0], second_pipe_[1], count - teed, 0);
+      if(got < 0 && EINTR == errno) continue;
+      if(got <= 0) break;
+      teed += static_cast<size_t>(got);
+    }
+    if(teed < count)
+    {
+      // tee copies from the front of the first pipe each time, so
+      // what reached the second pipe is the front of the chunk
+      this->GiveUpSplicing("tee");
+      DrainPipe(first_pipe_[0], count, first_fd_);
+      DrainPipe(second_pipe_[0], teed, second_fd_);
+      WriteAll(second_fd_, data + done + teed, count - teed);
+      done += count;
+      WriteAll(first_fd_, data + done, size - done);
+      WriteAll(second_fd_, data + done, size - done);
+      return true;
+    }
+
+    int pipes[2] = {first_pipe_[0], second_pipe_[0]};
+    int fds[2] = {first_fd_, second_fd_};
+    for(int which = 0; which < 2; ++which)
+    {
+      size_t spliced = 0;
+      while(splicing_ && (spliced < count))
+      {
+        ssize_t got = splice(pipes[which], nullptr, fds[which], nullptr,
+                             count - spliced, SPLICE_F_MOVE);
+        if(got < 0 && EINTR == errno) continue;
+        if(got <= 0)
+        {
+          this->GiveUpSplicing("splice");
+          break;
+        }
+        spliced += static_cast<size_t>(got);
+      }
+      if(spliced < count) DrainPipe(pipes[which], count - spliced,
+                                    fds[which]);
+    }
+    done += count;
+
+    if(!splicing_)
+    {
+      WriteAll(first_fd_, data + done, size - done);
+      WriteAll(second_fd_, data + done, size - done);
+      return true;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************************************
+ * Write all of 'data' to 'fd', however many calls it takes.
+**/
+void TeeSink::WriteAll(int fd, const char* data, size_t size) {
+  while(size > 0)
+  {
+    ssize_t written = write(fd, data, size);
+    if(written < 0 && EINTR == errno) continue;
+    if(written <= 0)
+    {
+      std::cout << kTag << "write failed (" << strerror(errno) << ")\n";
+      return;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+}
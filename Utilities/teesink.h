@@ -0,0 +1,75 @@
+/****************************************************************
+ * Header for the 'TeeSink' class.
+ *
+ * A 'TeeSink' writes the same text to two files with one copy
+ * out of the program. On Linux the text is moved into a pipe
+ * with 'vmsplice', duplicated into a second pipe with 'tee', and
+ * each pipe is moved into its file with 'splice', so the bytes
+ * never pass through a stream buffer and are never copied out
+ * of the program twice.
+ *
+ * If the kernel or a file system refuses any of these (or this
+ * is not Linux) the sink says so once and from then on writes
+ * the text to each file with 'write'. Anything already in the
+ * pipes is read back out and written first, so nothing is lost
+ * or reordered.
+ *
+ * The sink is opened on two 'ofstream's that are already open.
+ * It flushes them and writes to the same files through its own
+ * descriptors, at their ends, until 'Close', which moves the
+ * streams to the new ends of the files so they can go on. The
+ * streams must not be written while the sink is open.
+**/
+
+#ifndef TEESINK_H
+#define TEESINK_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+#include "utils.h"
+
+class TeeSink {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ TeeSink();
+ TeeSink(const TeeSink&) = delete;
+ TeeSink& operator=(const TeeSink&) = delete;
+ virtual ~TeeSink();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+ bool IsOpen() const;
+ bool IsSplicing() const;
+ bool Matches(const std::ofstream* first_stream,
+              const std::ofstream* second_stream) const;
+
+/****************************************************************
+ * General functions.
+**/
+ void Close();
+ bool Open(std::ofstream* first_stream, const std::string& first_filename,
+           std::ofstream* second_stream, const std::string& second_filename);
+ void Write(const char* data, size_t size);
+
+private:
+ std::ofstream* first_stream_ = nullptr;
+ std::ofstream* second_stream_ = nullptr;
+ int first_fd_ = -1;
+ int second_fd_ = -1;
+ int first_pipe_[2] = {-1, -1};
+ int second_pipe_[2] = {-1, -1};
+ size_t pipe_bytes_ = 0;
+ bool splicing_ = false;
+
+ void DrainPipe(int pipe_fd, size_t count, int fd);
+ void GiveUpSplicing(const std::string& call);
+ bool SpliceWrite(const char* data, size_t size);
+ static void WriteAll(int fd, const char* data, size_t size);
+};
+
+#endif // TEESINK_H
@@ -0,0 +1,157 @@
+#include "tokenizer.h"
+
+#include <charconv>
+#include <cstring>
+
+/****************************************************************
+ * Whitespace as the stream extraction operators define it.
+**/
+static bool IsWhitespace(const char c) {
+  return (' ' == c) || ('\n' == c) || ('\t' == c) || ('\r' == c)
+      || ('\v' == c) || ('\f' == c);
+}
+
+/****************************************************************
+ * Constructor.
+**/
+Tokenizer::Tokenizer() {
+}
+
+/****************************************************************
+ * Destructor.
+**/
+Tokenizer::~Tokenizer() {
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Function 'HasNext'.
+ *
+ * Returns:
+ *   true if there is another token, without moving past it
+**/
+bool Tokenizer::HasNext() const {
+  const char* where = cursor_;
+  while((where < end_) && IsWhitespace(*where)) ++where;
+  return where < end_;
+}
+
+/****************************************************************
+ * Function 'Next' to return the next token as a 'string'.
+**/
+std::string Tokenizer::Next() {
+  return std::string(this->NextView());
+}
+
+/****************************************************************
+ * Function 'NextDouble' to return the next token as a 'double'.
+ *
+ * Anything 'from_chars' will not take (a leading '+', say) goes
+ * through 'atof' just as the stream version did.
+**/
+double Tokenizer::NextDouble() {
+  std::string_view token = this->NextView();
+  if(token.empty()) return 0.0;
+
+  double value = 0.0;
+  std::from_chars_result result = std::from_chars(token.data(),
+                                                  token.data() + token.size(),
+                                                  value);
+  if((result.ec != std::errc()) || (result.ptr != token.data() + token.size()))
+  {
+    value = atof(std::string(token).c_str());
+  }
+  return value;
+}
+
+/****************************************************************
+ * Function 'NextInt' to return the next token as an 'int'.
+ *
+ * A token that is not a number goes to 'Utils::StringToInteger',
+ * which reports it and stops the program.
+**/
+int Tokenizer::NextInt() {
+  std::string_view token = this->NextView();
+  if(token.empty()) return 0;
+
+  int value = 0;
+  std::from_chars_result result = std::from_chars(token.data(),
+                                                  token.data() + token.size(),
+                                                  value);
+  if((result.ec != std::errc()) || (result.ptr != token.data() + token.size()))
+  {
+    value = Utils::StringToInteger(std::string(token));
+  }
+  return value;
+}
+
+/****************************************************************
+ * Function 'NextLine' to return the rest of the line.
+ *
+ * If a token has been read from the current line and only blanks
+ * are left after it, the stream version had used up that line,
+ * so this moves on to the next one. The newline is not returned
+ * and no other whitespace is trimmed.
+**/
+std::string Tokenizer::NextLine() {
+  if((cursor_ > begin_) && ('\n' != cursor_[-1]))
+  {
+    const char* where = cursor_;
+    while((where < end_) && ('\n' != *where) && IsWhitespace(*where)) ++where;
+    if((where < end_) && ('\n' == *where)) cursor_ = where + 1;
+    else if(where == end_) cursor_ = end_;
+  }
+
+  const char* line_end = static_cast<const char*>(
+                   memchr(cursor_, '\n', static_cast<size_t>(end_ - cursor_)));
+  if(nullptr == line_end) line_end = end_;
+
+  std::string line(cursor_, line_end);
+  cursor_ = (line_end < end_) ? line_end + 1 : end_;
+  return line;
+}
+
+/****************************************************************
+ * Function 'NextLONG' to return the next token as a 'LONG'.
+**/
+LONG Tokenizer::NextLONG() {
+  std::string_view token = this->NextView();
+  if(token.empty()) return 0;
+
+  LONG value = 0;
+  std::from_chars_result result = std::from_chars(token.data(),
+                                                  token.data() + token.size(),
+                                                  value);
+  if((result.ec != std::errc()) || (result.ptr != token.data() + token.size()))
+  {
+    value = Utils::StringToLONG(std::string(token));
+  }
+  return value;
+}
+
+/****************************************************************
+ * Function 'NextView' to return the next token in place.
+ *
+ * Returns:
+ *   a view of the next token, or an empty view if there is none
+**/
+std::string_view Tokenizer::NextView() {
+  while((cursor_ < end_) && IsWhitespace(*cursor_)) ++cursor_;
+
+  const char* token_begin = cursor_;
+  while((cursor_ < end_) && !IsWhitespace(*cursor_)) ++cursor_;
+
+  return std::string_view(token_begin,
+                          static_cast<size_t>(cursor_ - token_begin));
+}
+
+/****************************************************************
+ * Start reading a new range of characters.
+**/
+void Tokenizer::Reset(const char* begin, const char* end) {
+  begin_ = begin;
+  cursor_ = begin;
+  end_ = end;
+}
@@ -0,0 +1,53 @@
+/****************************************************************
+ * Header for the 'Tokenizer' class.
+ *
+ * A 'Tokenizer' reads whitespace separated tokens and lines out
+ * of a range of characters it does not own, such as a mapped
+ * file or the string inside a 'ScanLine'. Tokens are returned as
+ * 'std::string_view's into that range and numbers are parsed in
+ * place with 'std::from_chars', so nothing is copied and no
+ * locale is consulted.
+ *
+ * It follows the rules of the stream-based 'Scanner':
+ * 1.  a token is anything other than whitespace,
+ * 2.  'NextLine' returns the rest of the current line, or the
+ *     next line if nothing but blanks is left on this one,
+ * 3.  numbers that do not parse are handed to the same 'Utils'
+ *     conversion the stream version used, which reports them.
+**/
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <string>
+#include <string_view>
+
+#include "utils.h"
+
+class Tokenizer {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+ Tokenizer();
+ virtual ~Tokenizer();
+
+/****************************************************************
+ * General functions.
+**/
+ bool HasNext() const;
+ std::string Next();
+ double NextDouble();
+ int NextInt();
+ std::string NextLine();
+ LONG NextLONG();
+ std::string_view NextView();
+ void Reset(const char* begin, const char* end);
+
+private:
+ const char* begin_ = nullptr;
+ const char* cursor_ = nullptr;
+ const char* end_ = nullptr;
+};
+
+#endif // TOKENIZER_H
@@ -1,11 +1,21 @@
 #include "utils.h"
+#include "asyncwriter.h"
+#include "formatter.h"
+#include "teesink.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
 
 static const std::string kTag = "UTILS: ";
 static const std::string WHITESPACE = " \n\t\r";
 
 std::ofstream Utils::log_stream;
-std::ostringstream Utils::oss;
-std::stringstream Utils::ss;
+
+// Declared after log_stream, and the writer after the tee sink it
+// writes through, so each is destroyed, and stopped, before what it uses
+static TeeSink tee_output;
+static AsyncWriter async_output;
 
 /****************************************************************
  * Constructor.
@@ -41,6 +51,27 @@ void Utils::CheckArgs(const int howMany, const int argc,
   }
 }
 
+/****************************************************************
+ * Check for at least the required number of arguments.  Any
+ * arguments after the first 'howMany' are optional and are left
+ * for the caller to parse.
+ *
+ * Parameters:
+ *   howMany - the number of required arguments
+ *   argc - the usual 'argc' of command line information
+ *   argv - the usual 'argv' of command line information
+ *   usage - the 'usage' message to display on error
+ * Return: none
+**/
+void Utils::CheckArgsAtLeast(const int howMany, const int argc,
+                             char *argv[], const std::string usage) {
+  if(argc < howMany + 1)
+  {
+    std::cout << kTag << "usage: " << argv[0] << " " << usage << std::endl;
+    exit(1);
+  }
+}
+
 /****************************************************************
  * Close an input stream.
  *
@@ -210,7 +241,23 @@ void Utils::LogFileOpen(std::string filename) {
  *   'double' to a 'string' of 'width'
  *   'double' to a 'string' of 'width' and 'precision'
  *
+ * These used to share the one 'oss' stream, whose flags carried
+ * over from call to call: a 'left' justification held until an
+ * integer or a precision call set 'right' again, and 'fixed' and
+ * the precision held once set. Existing output depends on that
+ * (a double right after a 'left' string comes out on the left),
+ * so the same flags are kept in 'format_flags'. They and the
+ * 'Formatter' that builds each result are per thread, so threads
+ * no longer share a stream.
 **/
+static thread_local Formatter format_buffer;
+
+static thread_local struct FormatFlags {
+  bool left = false;
+  bool fixed = false;
+  int precision = 6;
+} format_flags;
+
 /****************************************************************
  * String-ify a 'char*' array, without width formatting.
  *
@@ -219,9 +266,7 @@ void Utils::LogFileOpen(std::string filename) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const char* value) {
-  Utils::oss.str("");
-  Utils::oss << std::string(value);
-  return oss.str();
+  return std::string(value);
 }
 
 /****************************************************************
@@ -234,9 +279,7 @@ std::string Utils::Format(const char* value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const char* value, const int width) {
-  Utils::oss.str("");
-  Utils::oss << std::setw(width) << std::string(value);
-  return oss.str();
+  return Utils::Format(std::string(value), width);
 }
 
 /****************************************************************
@@ -251,23 +294,7 @@ std::string Utils::Format(const char* value, const int width) {
 **/
 std::string Utils::Format(const char* value, const int width,
                           const std::string justify) {
-  Utils::oss.str("");
-
-  if("left" == justify)
-  {
-    Utils::oss.setf(std::ios::left, std::ios::adjustfield);
-    Utils::oss << std::setw(width) << std::string(value);
-  }
-  else if("right" == justify)
-  {
-    Utils::oss.setf(std::ios::right, std::ios::adjustfield);
-    Utils::oss << std::setw(width) << std::string(value);
-  }
-  else
-  {
-    Utils::oss << std::setw(width) << std::string(value);
-  }
-  return oss.str();
+  return Utils::Format(std::string(value), width, justify);
 }
 
 /****************************************************************
@@ -292,9 +319,10 @@ std::string Utils::Format(const std::string value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const std::string value, const int width) {
-  Utils::oss.str("");
-  Utils::oss << std::setw(width) << value;
-  return oss.str();
+  format_buffer.Clear();
+  if(format_flags.left) format_buffer.AppendLeft(value, width);
+  else format_buffer.AppendRight(value, width);
+  return format_buffer.GetString();
 }
 
 /****************************************************************
@@ -309,22 +337,10 @@ std::string Utils::Format(const std::string value, const int width) {
 **/
 std::string Utils::Format(const std::string value, const int width,
                           const std::string justify) {
-  Utils::oss.str("");
-  if("left" == justify)
-  {
-    Utils::oss.setf(std::ios::left, std::ios::adjustfield);
-    Utils::oss << std::setw(width) << value;
-  }
-  else if("right" == justify)
-  {
-    Utils::oss.setf(std::ios::right, std::ios::adjustfield);
-    Utils::oss << std::setw(width) << value;
-  }
-  else
-  {
-    Utils::oss << std::setw(width) << value;
-  }
-  return oss.str();
+  if("left" == justify) format_flags.left = true;
+  else if("right" == justify) format_flags.left = false;
+
+  return Utils::Format(value, width);
 }
 
 /****************************************************************
@@ -336,9 +352,7 @@ std::string Utils::Format(const std::string value, const int width,
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const short value) {
-  Utils::oss.str("");
-  Utils::oss << value;
-  return oss.str();
+  return Utils::Format(static_cast<LONG>(value));
 }
 
 /****************************************************************
@@ -351,10 +365,7 @@ std::string Utils::Format(const short value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const short value, const int width) {
-  Utils::oss.str("");
-  Utils::oss.setf(std::ios::right, std::ios::adjustfield);
-  Utils::oss << std::setw(width) << value;
-  return oss.str();
+  return Utils::Format(static_cast<LONG>(value), width);
 }
 
 /****************************************************************
@@ -366,9 +377,7 @@ std::string Utils::Format(const short value, const int width) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const int value) {
-  Utils::oss.str("");
-  Utils::oss << value;
-  return oss.str();
+  return Utils::Format(static_cast<LONG>(value));
 }
 
 /****************************************************************
@@ -381,10 +390,7 @@ std::string Utils::Format(const int value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const int value, const int width) {
-  Utils::oss.str("");
-  Utils::oss.setf(std::ios::right, std::ios::adjustfield);
-  Utils::oss << std::setw(width) << value;
-  return oss.str();
+  return Utils::Format(static_cast<LONG>(value), width);
 }
 
 /****************************************************************
@@ -396,9 +402,7 @@ std::string Utils::Format(const int value, const int width) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const UINT value) {
-  Utils::oss.str("");
-  Utils::oss << value;
-  return oss.str();
+  return Utils::Format(static_cast<LONG>(value));
 }
 
 /****************************************************************
@@ -411,10 +415,7 @@ std::string Utils::Format(const UINT value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const UINT value, const int width) {
-  Utils::oss.str("");
-  Utils::oss.setf(std::ios::right, std::ios::adjustfield);
-  Utils::oss << std::setw(width) << value;
-  return oss.str();
+  return Utils::Format(static_cast<LONG>(value), width);
 }
 
 /****************************************************************
@@ -426,9 +427,9 @@ std::string Utils::Format(const UINT value, const int width) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const LONG value) {
-  Utils::oss.str("");
-  Utils::oss << value;
-  return oss.str();
+  format_buffer.Clear();
+  format_buffer.AppendInt(value, 0);
+  return format_buffer.GetString();
 }
 
 /****************************************************************
@@ -441,11 +442,10 @@ std::string Utils::Format(const LONG value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const LONG value, const int width) {
-  int localWidth = static_cast<int>(width);
-  Utils::oss.str("");
-  Utils::oss.setf(std::ios::right, std::ios::adjustfield);
-  Utils::oss << std::setw(localWidth) << value;
-  return oss.str();
+  format_flags.left = false;
+  format_buffer.Clear();
+  format_buffer.AppendInt(value, width);
+  return format_buffer.GetString();
 }
 
 /****************************************************************
@@ -457,9 +457,7 @@ std::string Utils::Format(const LONG value, const int width) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const double value) {
-  Utils::oss.str("");
-  Utils::oss << value;
-  return oss.str();
+  return Utils::Format(value, 0);
 }
 
 /****************************************************************
@@ -476,11 +474,10 @@ std::string Utils::Format(const double value) {
  * Return: the string-ified version of 'value'
 **/
 std::string Utils::Format(const double value, const int width) {
-  Utils::oss.str("");
-  Utils::oss << std::setw(width) << value;
-
-  std::string returnString = Utils::Format(oss.str(), width);
-  return returnString;
+  format_buffer.Clear();
+  format_buffer.AppendDouble(value, width, format_flags.precision,
+                             format_flags.fixed, format_flags.left);
+  return format_buffer.GetString();
 }
 
 /****************************************************************
@@ -498,14 +495,52 @@ std::string Utils::Format(const double value, const int width) {
 **/
 std::string Utils::Format(const double value, const int width,
                           const int precision) {
-  Utils::oss.str("");
-  Utils::oss << std::fixed << std::setprecision(precision) << std::setw(width)
-             << value;
+  format_flags.fixed = true;
+  format_flags.precision = precision;
+  std::string returnString = Utils::Format(value, width);
 
-  std::string returnString = Utils::Format(oss.str(), width, "right");
+  // this went through Format(string, width, "right"), which stuck
+  format_flags.left = false;
   return returnString;
 }
 
+/****************************************************************
+ * Run 'task' once for each of 0 through 'count'-1, spread over
+ * up to 'thread_count' threads. Each thread takes the next
+ * undone subscript in turn, so uneven tasks still balance. The
+ * calling thread is one of the workers, and the function does
+ * not return until every task is done.
+ *
+ * Parameters:
+ *   count - the number of tasks
+ *   thread_count - the most threads to use
+ *   task - the function to call with each subscript
+ * Return: none
+**/
+void Utils::ParallelFor(const int count, const int thread_count,
+                        const std::function<void(int)>& task) {
+  std::atomic<int> next_task(0);
+  auto worker = [&]() {
+    int sub = next_task++;
+    while(sub < count)
+    {
+      task(sub);
+      sub = next_task++;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(int i = 1; (i < thread_count) && (i < count); ++i)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  worker();
+  for(UINT i = 0; i < threads.size(); ++i)
+  {
+    threads.at(i).join();
+  }
+}
+
 /****************************************************************
  * Replace blanks with another character.
  * This is to allow using an underscore to make a string one string
@@ -603,113 +638,6 @@ LONG Utils::StringToLONG(std::string input) {
   return return_value;
 } // LONG Utils::StringToLONG(std::string input)
 
-/****************************************************************
- * Call the timing function
- *
- * Parameters:
- *   timestring - the label to be put into the time log
- * Returns: the 'string' version of the timing log
-**/
-std::string Utils::TimeCall(const std::string time_string) {
-  static double time_new = 0.0;
-  return Utils::TimeCall(time_string, time_new);
-}
-
-/****************************************************************
- * Call the timing function
- *
- * Parameters:
- *   timestring - the label to be put into the time log
- * Returns: the 'string' version of the timing log
-**/
-std::string Utils::TimeCall(const std::string timestring, double& timeNew) {
-  char s[160];
-  std::string return_value;
-  static bool firsttime = true;
-  static double usercurrent = 0.0,userone = 0.0,usertwo = 0.0;
-  static double systemcurrent = 0.0,systemone = 0.0,systemtwo = 0.0;
-  static double cpupctone,cpupcttwo;
-  static double TIMEsystemtotal,TIMEusertotal;
-  static struct rusage rusage;
-  static time_t TIMEtcurrent,TIMEtone,TIMEttotal = 0.0,TIMEttwo;
-
-  if(firsttime)
-  {
-    firsttime = false;
-    TIMEusertotal = 0.0;
-    TIMEsystemtotal = 0.0;
-    TIMEtone = time(0);
-    TIMEttwo = time(0);
-  }
-
-  getrusage(RUSAGE_SELF,&rusage);
-
-  usertwo = (double) rusage.ru_utime.tv_sec;
-  usertwo += (double) rusage.ru_utime.tv_usec/1000000.0;
-  systemtwo = (double) rusage.ru_stime.tv_sec;
-  systemtwo += (double) rusage.ru_stime.tv_usec/1000000.0;
-
-  usercurrent = usertwo - userone;
-  systemcurrent = systemtwo - systemone;
-
-  TIMEusertotal += usercurrent;
-  TIMEsystemtotal += systemcurrent;
-
-  TIMEttwo = time(0);
-  TIMEtcurrent = TIMEttwo - TIMEtone;
-  TIMEttotal += TIMEtcurrent;
-  if(TIMEtcurrent != 0)
-  {
-    cpupctone = 100.0 * ((double)usercurrent+systemcurrent) /
-                           ((double)(TIMEtcurrent));
-    if(cpupctone > 100.0) cpupctone = 100.0;
-  }
-  else
-  {
-    cpupctone = 0.0;
-  }
-
-  if(TIMEttotal != 0)
-  {
-    cpupcttwo = 100.0 * ((double)TIMEusertotal+TIMEsystemtotal) /
-                           ((double)(TIMEttotal));
-    if(cpupcttwo > 100.0) cpupcttwo = 100.0;
-  }
-  else
-  {
-    cpupcttwo = 0.0;
-  }
-
-  return_value = "";
-  snprintf(s,80,"\nTIME***********************************************************************\n");
-  return_value += std::string(s);
-
-  snprintf(s,80,"TIME CPU percent  %6.2f %6.2f                    %s",
-             cpupctone,cpupcttwo,ctime(&TIMEttwo));
-  return_value += std::string(s);
-
-  snprintf(s,80,"TIME %-15s %10.2f u   %10.2f s   Res:%12ld\n",
-                 timestring.c_str(),usercurrent,systemcurrent, rusage.ru_maxrss);
-  return_value += std::string(s);
-
-  snprintf(s,80,"TIME %-15s %10.2f u_t %10.2f s_t\n",
-                 timestring.c_str(),TIMEusertotal,TIMEsystemtotal);
-  return_value += std::string(s);
-
-  snprintf(s,80,"TIME***********************************************************************\n");
-  return_value += std::string(s);
-
-  return_value += "\n\n";
-
-  userone = usertwo;
-  systemone = systemtwo;
-  TIMEtone = TIMEttwo;
-
-  timeNew = TIMEusertotal;
-
-  return return_value;
-} // std::string Utils::timecall(const std::string timestring)
-
 /****************************************************************
  * Convert a string to all lowercase.
  *
@@ -827,6 +755,78 @@ std::string Utils::Trim(std::string s) {
 **/
 void Utils::Output(std::string outstring, std::ofstream& first_stream,
                    std::ofstream& second_stream) {
+  if(async_output.IsRunning())
+  {
+    async_output.Write(std::move(outstring), &first_stream, &second_stream);
+    return;
+  }
+  if(tee_output.Matches(&first_stream, &second_stream))
+  {
+    tee_output.Write(outstring.data(), outstring.size());
+    return;
+  }
   first_stream << outstring;
   second_stream << outstring;
 }
+
+/****************************************************************
+ * The same for text bound for only one stream.
+**/
+void Utils::Output(std::string outstring, std::ofstream& stream) {
+  if(async_output.IsRunning())
+  {
+    async_output.Write(std::move(outstring), &stream, nullptr);
+    return;
+  }
+  stream << outstring;
+}
+
+/****************************************************************
+ * Send everything given to 'Output' from now on to a writer
+ * thread, holding at most 'max_queued_bytes' before 'Output'
+ * waits. Until 'StopAsyncOutput', nothing else may write to the
+ * streams given to 'Output'.
+**/
+void Utils::StartAsyncOutput(const size_t max_queued_bytes) {
+  async_output.Start(max_queued_bytes, &tee_output);
+}
+
+/****************************************************************
+ * A flush point: return once everything given to 'Output' so far
+ * is written and flushed. Does nothing unless output is async.
+**/
+void Utils::FlushOutput() {
+  async_output.Flush();
+}
+
+/****************************************************************
+ * Write what is still queued and go back to writing in 'Output'.
+**/
+void Utils::StopAsyncOutput() {
+  async_output.Stop();
+}
+
+/****************************************************************
+ * Have 'Output' write text bound for these two streams to both
+ * files at once through a 'TeeSink', until 'StopTeeOutput'.
+ * Start this before 'StartAsyncOutput' and stop it after.
+ *
+ * Returns:
+ *   false if the files could not be opened again, in which case
+ *   'Output' goes on writing the streams
+**/
+bool Utils::StartTeeOutput(std::ofstream& first_stream,
+                           const std::string first_filename,
+                           std::ofstream& second_stream,
+                           const std::string second_filename) {
+  return tee_output.Open(&first_stream, first_filename,
+                         &second_stream, second_filename);
+}
+
+/****************************************************************
+ * Go back to writing the streams, which carry on from the ends
+ * of the files.
+**/
+void Utils::StopTeeOutput() {
+  tee_output.Close();
+}
@@ -10,6 +10,8 @@
  *     output 'usage' message if incorrect.
  * 2.  open/close input, output, and log files.
  * 3.  timing
+ * 4.  running a loop of independent tasks on several threads
+ * 5.  writing output on a background thread
 **/
 
 #ifndef UTILS_H_
@@ -20,6 +22,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstdlib>
+#include <functional>
 #include <string>
 #include <time.h>
 #include <sys/time.h>
@@ -42,10 +45,6 @@ public:
 //  static ofstream outStream; //deprecated
  static std::ofstream log_stream;
 
-//  static stringstream utilsss(stringstream::in | stringstream::out);
- static std::stringstream ss;
- static std::ostringstream oss;
-
 /****************************************************************
  * Constructors and destructors for the class. 
 **/
@@ -57,6 +56,8 @@ public:
 **/
  static void CheckArgs(const int how_many, const int argc,
                        char *argv[], const std::string usage);
+ static void CheckArgsAtLeast(const int how_many, const int argc,
+                              char *argv[], const std::string usage);
 
 /****************************************************************
  * file open and close functions
@@ -109,17 +110,38 @@ public:
 //  static bool hasMoreData(ifstream& inStream);
 
  static std::string ReplaceBlanks(std::string input, char c);
- static std::string TimeCall(const std::string timestring);
- static std::string TimeCall(const std::string timestring, double& timenew);
  static void ToLower(std::string& to, const std::string from);
  static std::string TrimBlanks(std::string what);
  static std::string Trim(std::string what);
 
+/****************************************************************
+ * Run task(0) through task(count-1) on up to thread_count threads.
+**/
+ static void ParallelFor(const int count, const int thread_count,
+                         const std::function<void(int)>& task);
+
 /****************************************************************
  * Additional output function.  Added by William Edwards, 12/1/16
 **/
  static void Output(std::string outstring, std::ofstream& first_stream,
                     std::ofstream& second_stream);
+ static void Output(std::string outstring, std::ofstream& stream);
+
+/****************************************************************
+ * Have 'Output' hand its strings to a background writer thread.
+**/
+ static void FlushOutput();
+ static void StartAsyncOutput(const size_t max_queued_bytes);
+ static void StopAsyncOutput();
+
+/****************************************************************
+ * Have 'Output' write both files with one copy, by splice/tee.
+**/
+ static bool StartTeeOutput(std::ofstream& first_stream,
+                            const std::string first_filename,
+                            std::ofstream& second_stream,
+                            const std::string second_filename);
+ static void StopTeeOutput();
 
 private:
 };
@@ -0,0 +1,366 @@
+/*******************************************************************************
+ * Main program for the microbenchmarks of the simulation's hot paths.
+ *
+ * Times the pieces a run spends its time in, each on its own:
+ *   OnePct::RunSimulationPct2 at several voter and station counts
+ *   OnePct::RunSimulationPctEvents at the same counts
+ *   OnePct::CreateVoters at several voter counts
+ *   MyRandom's four distributions
+ *   Scanner::NextInt over all of 'dataallsorted.txt'
+ *   Utils::Format of ints and doubles
+ *
+ *   Bprog configfile jsonfile [name]
+ *
+ * runs them all, or those whose names start with 'name', and writes the
+ * results to 'jsonfile' and a table to standard output. 'make bench' runs
+ * them all into 'bench.json'.
+ *
+ * Each benchmark is first run with more and more operations until one
+ * sample takes at least kMinSampleNs, so the clock's resolution does not
+ * matter. Then one sample is thrown away as a warm-up and kSamples are
+ * timed. The JSON gives the median, the median absolute deviation and the
+ * quartiles of the time per operation, which a few slow samples (another
+ * process, a page fault) do not move, as well as the mean, the minimum and
+ * the maximum. Anything a benchmark has to set up between operations, such
+ * as copying the voters back before simulating them again, is not timed.
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/scanner.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+#include "configuration.h"
+#include "myrandom.h"
+#include "onepct.h"
+
+static const string kTag = "BENCH: ";
+static const int kSamples = 21;
+static const LONG kMinSampleNs = 20 * 1000 * 1000;
+static const int kRandomCallsPerOp = 1000;
+static const int kFormatCallsPerOp = 1000;
+static const int kBenchSeed = 19;
+
+// The results of the distributions and formats are added here so the
+// calls cannot be optimized away
+static volatile double bench_sink = 0.0;
+
+/*******************************************************************************
+ * One benchmark: 'op' does 'count' operations and returns the nanoseconds
+ * they took, not counting any setup between them. 'items' is how many of
+ * something (voters, numbers) one operation handles.
+**/
+struct Benchmark {
+  string name;
+  string params;
+  LONG items;
+  function<LONG(LONG)> op;
+};
+
+/*******************************************************************************
+ * Gives the benchmarks the private engines of a precinct.
+**/
+class OnePctBench {
+public:
+  // A precinct with 'voters' expected voters and nothing to histogram
+  static OnePct MakePct(int voters) {
+    PctRecord record;
+    memset(&record, 0, sizeof(record));
+    record.number = voters;
+    record.num_voters = voters;
+    record.expected_voters = voters;
+    record.expected_per_hour = voters / 13;
+    record.stations = 1;
+    record.turnout = 0.5;
+    record.minority = 0.3;
+    memcpy(record.name, "BENCH", 5);
+    OnePct pct;
+    pct.ReadRecord(record);
+    return pct;
+  }
+
+  static int MinStations(const Configuration& config, int voters) {
+    int stations = voters * config.time_to_vote_mean_seconds_
+                   / (config.election_day_length_hours_ * 3600);
+    return (stations <= 0) ? 1 : stations;
+  }
+
+  static LONG CreateVoters(const Configuration& config, OnePct& pct,
+                           MyRandom& random, LONG count) {
+    LONG elapsed = 0;
+    for (LONG op = 0; op < count; ++op) {
+      LONG start = NowNs();
+      pct.CreateVoters(config, random);
+      elapsed += NowNs() - start;
+    }
+    return elapsed;
+  }
+
+  static LONG RunSimulationPct2(OnePct& pct, int stations, LONG count) {
+    LONG elapsed = 0;
+    for (LONG op = 0; op < count; ++op) {
+      pct.voters_pending_ = pct.voters_backup_;
+      pct.voters_voting_.clear();
+      pct.voters_done_voting_.clear();
+      LONG start = NowNs();
+      pct.RunSimulationPct2(stations);
+      elapsed += NowNs() - start;
+    }
+    return elapsed;
+  }
+
+  static LONG RunSimulationPctEvents(OnePct& pct, int stations, LONG count) {
+    LONG elapsed = 0;
+    for (LONG op = 0; op < count; ++op) {
+      pct.voters_pending_ = pct.voters_backup_;
+      pct.voters_voting_.clear();
+      pct.voters_done_voting_.clear();
+      LONG start = NowNs();
+      pct.RunSimulationPctEvents(stations);
+      elapsed += NowNs() - start;
+    }
+    return elapsed;
+  }
+
+  static LONG NowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+           chrono::steady_clock::now().time_since_epoch()).count();
+  }
+};
+
+/*******************************************************************************
+ * Times 'count' runs of a function that needs no setup.
+**/
+static LONG TimeLoop(LONG count, const function<void()>& body) {
+  LONG start = OnePctBench::NowNs();
+  for (LONG op = 0; op < count; ++op) {
+    body();
+  }
+  return OnePctBench::NowNs() - start;
+}
+
+/*******************************************************************************
+ * The value at fraction 'where' of sorted 'values', between neighbours.
+**/
+static double Quantile(const vector<double>& values, double where) {
+  double position = where * (values.size() - 1);
+  UINT below = static_cast<UINT>(position);
+  UINT above = min(below + 1, static_cast<UINT>(values.size() - 1));
+  double fraction = position - below;
+  return values.at(below) * (1.0 - fraction) + values.at(above) * fraction;
+}
+
+/*******************************************************************************
+ * Runs one benchmark and adds its JSON object to 'json' and its line to
+ * 'table'.
+**/
+static void RunBenchmark(const Benchmark& bench, bool first, Formatter& json,
+                         Formatter& table) {
+  LONG count = 1;
+  while (bench.op(count) < kMinSampleNs)
+    count *= 2;
+
+  bench.op(count);
+  vector<double> per_op;
+  for (int sample = 0; sample < kSamples; ++sample) {
+    per_op.push_back(static_cast<double>(bench.op(count)) / count);
+  }
+
+  double mean = 0.0;
+  for (UINT sub = 0; sub < per_op.size(); ++sub) {
+    mean += per_op.at(sub) / per_op.size();
+  }
+  sort(per_op.begin(), per_op.end());
+  double median = Quantile(per_op, 0.5);
+  vector<double> deviations;
+  for (UINT sub = 0; sub < per_op.size(); ++sub) {
+    deviations.push_back(per_op.at(sub) > median ? per_op.at(sub) - median
+                                                 : median - per_op.at(sub));
+  }
+  sort(deviations.begin(), deviations.end());
+  double mad = Quantile(deviations, 0.5);
+
+  json.Append(first ? "\n" : ",\n");
+  json.Append("    {\"name\": \"" + bench.name + "\", \"params\": {"
+              + bench.params + "},\n");
+  json.Append("     \"samples\": ");
+  json.AppendInt(kSamples, 1);
+  json.Append(", \"ops_per_sample\": ");
+  json.AppendInt(count, 1);
+  json.Append(", \"items_per_op\": ");
+  json.AppendInt(bench.items, 1);
+  json.Append(",\n     \"ns_per_op\": {\"median\": ");
+  json.AppendFixed(median, 1, 1);
+  json.Append(", \"mad\": ");
+  json.AppendFixed(mad, 1, 1);
+  json.Append(", \"p25\": ");
+  json.AppendFixed(Quantile(per_op, 0.25), 1, 1);
+  json.Append(", \"p75\": ");
+  json.AppendFixed(Quantile(per_op, 0.75), 1, 1);
+  json.Append(", \"mean\": ");
+  json.AppendFixed(mean, 1, 1);
+  json.Append(", \"min\": ");
+  json.AppendFixed(per_op.front(), 1, 1);
+  json.Append(", \"max\": ");
+  json.AppendFixed(per_op.back(), 1, 1);
+  json.Append("},\n     \"ns_per_item_median\": ");
+  json.AppendFixed(median / bench.items, 1, 3);
+  json.Append("}");
+
+  table.AppendLeft(bench.name, 24);
+  table.AppendLeft(bench.params, 32);
+  table.AppendFixed(median, 16, 1);
+  table.AppendFixed(100.0 * mad / median, 8, 2);
+  table.AppendFixed(median / bench.items, 14, 3);
+  table.Append("\n");
+  cout << table.GetString();
+  table.Clear();
+}
+
+int main(int argc, char *argv[]) {
+  Utils::CheckArgsAtLeast(2, argc, argv, "configfile jsonfile [name]");
+  string config_filename = static_cast<string>(argv[1]);
+  string json_filename = static_cast<string>(argv[2]);
+  string only = (argc > 3) ? static_cast<string>(argv[3]) : "";
+
+  Configuration config;
+  Scanner config_stream;
+  config_stream.OpenFile(config_filename);
+  config.ReadConfiguration(config_stream);
+  config_stream.Close();
+
+  vector<Benchmark> benches;
+
+  // The engines, on precincts from small to the largest we see
+  static const int kVoterCounts[] = {500, 2000, 8000};
+  for (int voters : kVoterCounts) {
+    auto pct = make_shared<OnePct>(OnePctBench::MakePct(voters));
+    auto random = make_shared<MyRandom>(kBenchSeed);
+    benches.push_back(Benchmark{"CreateVoters",
+      "\"voters\": " + to_string(voters), voters,
+      [&config, pct, random](LONG count) {
+        return OnePctBench::CreateVoters(config, *pct, *random, count);
+      }});
+
+    int min_stations = OnePctBench::MinStations(config, voters);
+    for (int stations : {min_stations, min_stations + 3}) {
+      auto sim_pct = make_shared<OnePct>(OnePctBench::MakePct(voters));
+      MyRandom sim_random(kBenchSeed);
+      OnePctBench::CreateVoters(config, *sim_pct, sim_random, 1);
+      benches.push_back(Benchmark{"RunSimulationPct2",
+        "\"voters\": " + to_string(voters) + ", \"stations\": "
+        + to_string(stations), voters,
+        [sim_pct, stations](LONG count) {
+          return OnePctBench::RunSimulationPct2(*sim_pct, stations, count);
+        }});
+      benches.push_back(Benchmark{"RunSimulationPctEvents",
+        "\"voters\": " + to_string(voters) + ", \"stations\": "
+        + to_string(stations), voters,
+        [sim_pct, stations](LONG count) {
+          return OnePctBench::RunSimulationPctEvents(*sim_pct, stations,
+                                                     count);
+        }});
+    }
+  }
+
+  // The distributions, kRandomCallsPerOp calls to an operation
+  auto random = make_shared<MyRandom>(kBenchSeed);
+  int max_service = config.GetMaxServiceSubscript();
+  benches.push_back(Benchmark{"RandomExponentialInt", "\"lambda\": 0.5",
+    kRandomCallsPerOp, [random](LONG count) {
+      return TimeLoop(count * kRandomCallsPerOp, [random]() {
+        bench_sink = bench_sink + random->RandomExponentialInt(0.5);
+      });
+    }});
+  benches.push_back(Benchmark{"RandomNormal", "\"mean\": 0, \"dev\": 1",
+    kRandomCallsPerOp, [random](LONG count) {
+      return TimeLoop(count * kRandomCallsPerOp, [random]() {
+        bench_sink = bench_sink + random->RandomNormal(0.0, 1.0);
+      });
+    }});
+  benches.push_back(Benchmark{"RandomUniformDouble", "\"range\": 1",
+    kRandomCallsPerOp, [random](LONG count) {
+      return TimeLoop(count * kRandomCallsPerOp, [random]() {
+        bench_sink = bench_sink + random->RandomUniformDouble(0.0, 1.0);
+      });
+    }});
+  benches.push_back(Benchmark{"RandomUniformInt",
+    "\"range\": " + to_string(max_service + 1), kRandomCallsPerOp,
+    [random, max_service](LONG count) {
+      return TimeLoop(count * kRandomCallsPerOp, [random, max_service]() {
+        bench_sink = bench_sink + random->RandomUniformInt(0, max_service);
+      });
+    }});
+
+  // Parsing, the whole service time file to an operation
+  benches.push_back(Benchmark{"Scanner::NextInt",
+    "\"file\": \"dataallsorted.txt\"",
+    static_cast<LONG>(config.actual_service_times_.size()),
+    [](LONG count) {
+      return TimeLoop(count, []() {
+        Scanner infile;
+        infile.OpenFile("dataallsorted.txt");
+        while (infile.HasNext()) {
+          bench_sink = bench_sink + infile.NextInt();
+        }
+        infile.Close();
+      });
+    }});
+
+  // Formatting, kFormatCallsPerOp calls to an operation
+  benches.push_back(Benchmark{"Utils::Format",
+    "\"type\": \"int\", \"width\": 8",
+    kFormatCallsPerOp, [](LONG count) {
+      return TimeLoop(count * kFormatCallsPerOp, []() {
+        bench_sink = bench_sink + Utils::Format(123456, 8).length();
+      });
+    }});
+  benches.push_back(Benchmark{"Utils::Format",
+    "\"type\": \"double\", \"width\": 8, \"precision\": 2",
+    kFormatCallsPerOp, [](LONG count) {
+      return TimeLoop(count * kFormatCallsPerOp, []() {
+        bench_sink = bench_sink + Utils::Format(1234.5678, 8, 2).length();
+      });
+    }});
+
+  Formatter json;
+  Formatter table;
+  json.Append("{\n  \"samples\": ");
+  json.AppendInt(kSamples, 1);
+  json.Append(",\n  \"min_sample_ns\": ");
+  json.AppendInt(kMinSampleNs, 1);
+  json.Append(",\n  \"benchmarks\": [");
+
+  table.AppendLeft("benchmark", 24);
+  table.AppendLeft("params", 32);
+  table.AppendRight("median ns/op", 16);
+  table.AppendRight("mad %", 8);
+  table.AppendRight("ns/item", 14);
+  table.Append("\n");
+  cout << table.GetString();
+  table.Clear();
+
+  bool first = true;
+  for (UINT sub = 0; sub < benches.size(); ++sub) {
+    if (0 != benches.at(sub).name.compare(0, only.length(), only))
+      continue;
+    RunBenchmark(benches.at(sub), first, json, table);
+    first = false;
+  }
+  json.Append("\n  ]\n}\n");
+
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, json_filename);
+  out_stream << json.GetString();
+  Utils::FileClose(out_stream);
+  cout << kTag << "wrote '" << json_filename << "'" << endl;
+  return 0;
+}
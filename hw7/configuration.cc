@@ -20,6 +20,11 @@
  * that takes in the hard coded file "dataallsorted.txt" and adds those values
  * to the appropriate variables.
  *
+ * IsPctSelected(pct_number) says whether '--pcts' asked for that precinct.
+ *
+ * ReadOptions(argc, argv, first_option) reads the optional '--name=value'
+ * arguments that follow the file names on the command line.
+ *
  * ToString () takes all the calculations done in ReadConfiguration () and 
  * formats into a easily readable string to be output to the user.
 **/
@@ -46,6 +51,20 @@ int Configuration::GetMaxServiceSubscript() const {
   return static_cast<int>(actual_service_times_.size()) - 1;
 }
 
+/*******************************************************************************
+ * Every precinct is selected unless '--pcts' gave a list.
+**/
+bool Configuration::IsPctSelected(int pct_number) const {
+  if (pct_ranges_.empty())
+    return true;
+  for (UINT sub = 0; sub < pct_ranges_.size(); ++sub) {
+    if ((pct_number >= pct_ranges_.at(sub).first) &&
+        (pct_number <= pct_ranges_.at(sub).second))
+      return true;
+  }
+  return false;
+}
+
 /*******************************************************************************
  * General functions.
 **/
@@ -83,37 +102,200 @@ void Configuration::ReadConfiguration(Scanner& instream) {
   }
 }
 
+/*******************************************************************************
+ * Function 'ReadOptions'.
+ * Reads the optional arguments 'argv[first_option]' onward. Each one has the
+ * form '--name=value'. An unknown name prints the list of options and exits,
+ * the same way 'Utils::CheckArgs' handles a bad argument count.
+ *
+ *   --threads=N             threads the simulation may use (default 1)
+ *   --time-parallel-min=N   smallest precinct run as parallel windows
+ *   --hourly-streams        generate each hour's voters from its own stream
+ *   --streaming             keep only running statistics, not the voters
+ *   --compile=FILE          write an input bundle to FILE and stop
+ *   --pcts=LIST             simulate only these precincts, e.g. '101,140-160'
+ *   --pipeline              read, simulate and write precincts concurrently
+ *   --async-output[=MB]     write output on a background thread, holding at
+ *                           most MB megabytes (default 8) before waiting
+ *   --tee-output            write output and log together with splice/tee
+ *   --out-verbosity=LEVEL   how much goes to the output file: 'summary',
+ *                           'count', 'iteration' (the default) or 'voter'
+ *   --log-verbosity=LEVEL   the same for the log
+ *                           (with different verbosities the output file and
+ *                           log are different, and --tee-output is ignored)
+ *   --results=FILE          also write every iteration's numbers to FILE as a
+ *                           binary results store, for Rprog to read
+ *   --trace=FILE            also write every voter of every iteration to FILE
+ *                           as a voter trace, which Rprog also reads
+ *   --perf-counters         add hardware counters (IPC, cache and branch
+ *                           misses per voter) to the timing report
+ *   --chrome-trace=FILE     write a timeline of the run's timers and queues
+ *                           to FILE, for chrome://tracing or Perfetto
+ *   --metrics=FILE          keep progress metrics in FILE for Prometheus
+ *   --metrics-interval=N    rewrite the metrics every N seconds (default 15)
+ *   --alloc-stats           add allocations and peak live bytes, by precinct
+ *                           and phase, to the timing report (Aprog-alloc,
+ *                           'make Aprog-alloc', only)
+ *   --profile=FILE          sample the call stacks of every thread and write
+ *                           them to FILE as folded stacks for flame graphs
+ *   --profile-hz=N          samples per CPU second (default 99)
+**/
+void Configuration::ReadOptions(int argc, char *argv[], int first_option) {
+  for (int sub = first_option; sub < argc; ++sub) {
+    string option = static_cast<string>(argv[sub]);
+    string name = option;
+    string value = "";
+
+    string::size_type equals = option.find("=");
+    if (equals != string::npos) {
+      name = option.substr(0, equals);
+      value = option.substr(equals + 1);
+    }
+
+    if ("--threads" == name) {
+      thread_count_ = Utils::StringToInteger(value);
+      if (thread_count_ <= 0)
+        thread_count_ = 1;
+    } else if ("--time-parallel-min" == name) {
+      time_parallel_min_voters_ = Utils::StringToInteger(value);
+    } else if ("--hourly-streams" == name) {
+      hourly_voter_streams_ = true;
+    } else if ("--streaming" == name) {
+      hourly_voter_streams_ = true;
+      streaming_voters_ = true;
+    } else if ("--compile" == name) {
+      compile_filename_ = value;
+    } else if ("--async-output" == name) {
+      int megabytes = kDefaultAsyncOutputMegabytes;
+      if (value != "")
+        megabytes = Utils::StringToInteger(value);
+      if (megabytes <= 0)
+        megabytes = 1;
+      async_output_bytes_ = static_cast<size_t>(megabytes) * 1024 * 1024;
+    } else if ("--tee-output" == name) {
+      tee_output_ = true;
+    } else if ("--out-verbosity" == name) {
+      out_verbosity_ = ReadVerbosity(option, value);
+    } else if ("--log-verbosity" == name) {
+      log_verbosity_ = ReadVerbosity(option, value);
+    } else if ("--results" == name) {
+      results_filename_ = value;
+    } else if ("--trace" == name) {
+      trace_filename_ = value;
+    } else if ("--metrics" == name) {
+      metrics_filename_ = value;
+    } else if ("--metrics-interval" == name) {
+      metrics_seconds_ = Utils::StringToInteger(value);
+      if (metrics_seconds_ <= 0)
+        metrics_seconds_ = 1;
+    } else if ("--profile" == name) {
+      profile_filename_ = value;
+    } else if ("--profile-hz" == name) {
+      profile_hz_ = Utils::StringToInteger(value);
+      if (profile_hz_ <= 0)
+        profile_hz_ = kDefaultProfileHz;
+    } else if ("--alloc-stats" == name) {
+      alloc_stats_ = true;
+    } else if ("--chrome-trace" == name) {
+      chrome_trace_filename_ = value;
+    } else if ("--perf-counters" == name) {
+      perf_counters_ = true;
+    } else if ("--pipeline" == name) {
+      pipeline_ = true;
+    } else if ("--pcts" == name) {
+      string::size_type start = 0;
+      while (start < value.length()) {
+        string::size_type comma = value.find(",", start);
+        if (comma == string::npos)
+          comma = value.length();
+        string item = value.substr(start, comma - start);
+        string::size_type dash = item.find("-", 1);
+        int low = Utils::StringToInteger(item.substr(0, dash));
+        int high = low;
+        if (dash != string::npos)
+          high = Utils::StringToInteger(item.substr(dash + 1));
+        pct_ranges_.push_back(make_pair(low, high));
+        start = comma + 1;
+      }
+    } else {
+      cout << kTag << "unknown option '" << option << "'" << endl;
+      cout << kTag << "options: --threads=N --time-parallel-min=N"
+           << " --hourly-streams --streaming --compile=FILE"
+           << " --pcts=LIST --pipeline --async-output[=MB]"
+           << " --tee-output --out-verbosity=LEVEL"
+           << " --log-verbosity=LEVEL --results=FILE"
+           << " --trace=FILE --perf-counters --chrome-trace=FILE"
+           << " --metrics=FILE --metrics-interval=N --alloc-stats"
+           << " --profile=FILE --profile-hz=N" << endl;
+      exit(1);
+    }
+  }
+}
+
+/*******************************************************************************
+ * Function 'ReadVerbosity'.
+ * Returns the kVerbose level named by a verbosity option's value. An unknown
+ * name prints the names and exits, as an unknown option does.
+**/
+int Configuration::ReadVerbosity(const string& option, const string& value) {
+  if ("summary" == value)
+    return kVerboseSummary;
+  if ("count" == value)
+    return kVerbosePerCount;
+  if ("iteration" == value)
+    return kVerbosePerIteration;
+  if ("voter" == value)
+    return kVerbosePerVoter;
+
+  cout << kTag << "unknown verbosity in '" << option << "'" << endl;
+  cout << kTag << "verbosities: summary count iteration voter" << endl;
+  exit(1);
+}
+
 string Configuration::ToString() {
   const int kOffset = 6;
+  Formatter s;
   
-  string s = "\n" + kTag + "RN seed:              ";
-  s.append(Utils::Format(seed_, 8) + "\n");
-  s.append(kTag + "Election Day length:  ");
-  s.append(Utils::Format(election_day_length_seconds_, 8) + " =");
-  s.append(Utils::Format(election_day_length_seconds_ / 3600.0, 8, 2) + " (");
-  s.append(Utils::Format(election_day_length_hours_, 8, 2) + ") hours\n");
-  s.append(kTag + "Time to vote mean:    ");
-  s.append(Utils::Format(time_to_vote_mean_seconds_, 8) + " =");
-  s.append(Utils::Format(time_to_vote_mean_seconds_ / 60.0, 8, 2));
-  s.append(" minutes\n" + kTag);
-  s.append("Min and max expected voters for this simulation:     ");
-  s.append(Utils::Format(min_expected_to_simulate_, 8));
-  s.append(Utils::Format(max_expected_to_simulate_, 8) + "\n");
-  s.append("Wait time (minutes) that is 'too long': ");
-  s.append(Utils::Format(wait_time_minutes_that_is_too_long_, 8) + "\n");
-  s.append("Number of iterations to perform: ");
-  s.append(Utils::Format(number_of_iterations_, 4) + "\n");
-  s.append("Max service time subscript: ");
-  s.append(Utils::Format(GetMaxServiceSubscript(), 6) + "\n");
-  s.append(kTag + Utils::Format(0, 2) + "-" + Utils::Format(0, 2));
-  s.append(" : " + Utils::Format(arrival_zero_, 7, 2) + "\n");
+  s.Append("\n" + kTag + "RN seed:              ");
+  s.AppendInt(seed_, 8);
+  s.Append("\n" + kTag + "Election Day length:  ");
+  s.AppendInt(election_day_length_seconds_, 8);
+  s.Append(" =");
+  s.AppendFixed(election_day_length_seconds_ / 3600.0, 8, 2);
+  s.Append(" (");
+  s.AppendFixed(election_day_length_hours_, 8, 2);
+  s.Append(") hours\n" + kTag + "Time to vote mean:    ");
+  s.AppendInt(time_to_vote_mean_seconds_, 8);
+  s.Append(" =");
+  s.AppendFixed(time_to_vote_mean_seconds_ / 60.0, 8, 2);
+  s.Append(" minutes\n" + kTag);
+  s.Append("Min and max expected voters for this simulation:     ");
+  s.AppendInt(min_expected_to_simulate_, 8);
+  s.AppendInt(max_expected_to_simulate_, 8);
+  s.Append("\nWait time (minutes) that is 'too long': ");
+  s.AppendInt(wait_time_minutes_that_is_too_long_, 8);
+  s.Append("\nNumber of iterations to perform: ");
+  s.AppendInt(number_of_iterations_, 4);
+  s.Append("\nMax service time subscript: ");
+  s.AppendInt(GetMaxServiceSubscript(), 6);
+  s.Append("\n" + kTag);
+  s.AppendInt(0, 2);
+  s.Append("-");
+  s.AppendInt(0, 2);
+  s.Append(" : ");
+  s.AppendFixed(arrival_zero_, 7, 2);
+  s.Append("\n");
   
   for (UINT sub = 0; sub < arrival_fractions_.size(); ++sub) {
-    s.append(kTag + Utils::Format(kOffset + sub, 2));
-    s.append("-" + Utils::Format(kOffset + sub + 1, 2));
-    s.append(" : " + Utils::Format(arrival_fractions_.at(sub), 7, 2) + "\n");
+    s.Append(kTag);
+    s.AppendInt(kOffset + sub, 2);
+    s.Append("-");
+    s.AppendInt(kOffset + sub + 1, 2);
+    s.Append(" : ");
+    s.AppendFixed(arrival_fractions_.at(sub), 7, 2);
+    s.Append("\n");
   }
   
-  s.append("\n");
-  return s;
+  s.Append("\n");
+  return s.GetString();
 }
@@ -17,6 +17,11 @@
  * ReadConfiguration(Scanner& instream) takes in an instance of scanner and
  * manipulates it.
  *
+ * IsPctSelected(pct_number) says whether '--pcts' asked for that precinct.
+ *
+ * ReadOptions(argc, argv, first_option) reads the optional '--name=value'
+ * arguments that follow the file names on the command line.
+ *
  * ToString () takes all the calculations done in ReadConfiguration () and 
  * formats into a easily readable string to be output to the user.
  *
@@ -29,6 +34,7 @@
 #include <set>
 #include <vector>
 
+#include "../Utilities/formatter.h"
 #include "../Utilities/utils.h"
 #include "../Utilities/scanner.h"
 #include "../Utilities/scanline.h"
@@ -40,6 +46,19 @@ using namespace std;
 static const int kDefaultSeed = 19;
 static const int kDummyConfigInt = -111;
 static const double kDummyConfigDouble = -22.22;
+static const int kDefaultThreadCount = 1;
+static const int kDefaultTimeParallelMinVoters = 10000;
+static const int kDefaultAsyncOutputMegabytes = 8;
+static const int kDefaultMetricsSeconds = 15;
+static const int kDefaultProfileHz = 99;
+
+// Verbosity levels for the output file and the log. Each level includes the
+// ones before it.
+static const int kVerboseSummary = 0;       // per station count summaries
+static const int kVerbosePerCount = 1;      // precinct headers and histograms
+static const int kVerbosePerIteration = 2;  // a line per iteration
+static const int kVerbosePerVoter = 3;      // every voter of every iteration
+static const int kDefaultVerbosity = kVerbosePerIteration;
 
 class Configuration {
 public:
@@ -69,15 +88,80 @@ public:
  double arrival_zero_ = kDummyConfigDouble;
  vector<double> arrival_fractions_;
 
+/*******************************************************************************
+ * Run options, set from the optional '--name=value' command line arguments.
+ *
+ * thread_count_ is the number of threads the simulation may use.
+ * time_parallel_min_voters_ is the smallest precinct (expected voters) that
+ * is cut into hourly windows run in parallel when thread_count_ > 1; smaller
+ * ones, and every precinct on one thread, are simulated event by event. Each
+ * window costs a thread start, and below about 10000 voters a window's work
+ * (well under a millisecond) is no larger than that start.
+ * hourly_voter_streams_ generates each hour's voters from its own random
+ * stream, in parallel. This gives different (equally valid) voters than
+ * the single stream, so it is off unless asked for.
+ * streaming_voters_ simulates with voters generated as needed and statistics
+ * kept as it goes, so no iteration ever holds all its voters. It uses the
+ * hourly streams.
+ * compile_filename_, if not empty, is where to write an input bundle of the
+ * configuration and precincts instead of running the simulation.
+ * pct_ranges_ are the inclusive ranges of precinct numbers to simulate. If
+ * it is empty every precinct is simulated.
+ * pipeline_ reads, simulates and writes a text precinct file a few
+ * precincts at a time, on threads, instead of reading it all first.
+ * async_output_bytes_, if not zero, has the simulation's output written on a
+ * background thread, holding at most this many bytes waiting to be written.
+ * tee_output_ writes text meant for both the output file and the log once,
+ * duplicated into both files by splice and tee where the system allows.
+ * out_verbosity_ and log_verbosity_ are how much of each precinct's report
+ * goes to the output file and to the log, one of the kVerbose levels.
+ * results_filename_, if not empty, is where to write a binary results store
+ * of the numbers on every per-iteration line.
+ * trace_filename_, if not empty, is where to write a compact binary trace of
+ * every voter of every iteration.
+ * perf_counters_ counts hardware events under the run's timers, where the
+ * system allows it.
+ * chrome_trace_filename_, if not empty, is where to write a trace-event
+ * timeline of the timers on every thread and of the pipeline's queues.
+ * metrics_filename_, if not empty, is where to keep progress metrics in the
+ * Prometheus text format, rewritten every metrics_seconds_.
+ * alloc_stats_ counts allocations under the run's timers.
+ * profile_filename_, if not empty, is where to write the call stacks sampled
+ * profile_hz_ times a CPU second, as folded stacks for flame graphs.
+**/
+ int thread_count_ = kDefaultThreadCount;
+ int time_parallel_min_voters_ = kDefaultTimeParallelMinVoters;
+ bool hourly_voter_streams_ = false;
+ bool streaming_voters_ = false;
+ string compile_filename_ = "";
+ vector<pair<int, int> > pct_ranges_;
+ bool pipeline_ = false;
+ size_t async_output_bytes_ = 0;
+ bool tee_output_ = false;
+ int out_verbosity_ = kDefaultVerbosity;
+ int log_verbosity_ = kDefaultVerbosity;
+ string results_filename_ = "";
+ string trace_filename_ = "";
+ bool perf_counters_ = false;
+ string chrome_trace_filename_ = "";
+ string metrics_filename_ = "";
+ int metrics_seconds_ = kDefaultMetricsSeconds;
+ bool alloc_stats_ = false;
+ string profile_filename_ = "";
+ int profile_hz_ = kDefaultProfileHz;
+
 /*******************************************************************************
  * General functions.
 **/
 
  int GetMaxServiceSubscript() const;
+ bool IsPctSelected(int pct_number) const;
  void ReadConfiguration(Scanner& instream);
+ void ReadOptions(int argc, char *argv[], int first_option);
  string ToString();
 
 private:
+ static int ReadVerbosity(const string& option, const string& value);
 
 };
 
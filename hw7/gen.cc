@@ -0,0 +1,379 @@
+/*******************************************************************************
+ * Main program for the synthetic precinct and configuration generator.
+ *
+ * Makes inputs of any size for scale testing, so a run like production's
+ * can be reproduced without production's files.
+ *
+ *   Gprog outdir pctcount [options]
+ *
+ * writes into 'outdir' (made if it is not there):
+ *   pcts.txt             'pctcount' precincts (10 to 100000) in the format
+ *                        'OnePct::ReadData' reads
+ *   config_PROFILE.txt   one configuration per arrival profile, as
+ *                        'Configuration::ReadConfiguration' reads
+ *   dataallsorted.txt    the service times, in seconds, in increasing order
+ *
+ * 'ReadConfiguration' always reads the service times from 'dataallsorted.txt'
+ * in the directory it runs in, so the simulation is run from 'outdir':
+ *   cd outdir && ../Aprog config_flat.txt pcts.txt out log
+ * Every configuration's time to vote mean is the mean of the service times
+ * that were written, so the station counts the simulation starts from match
+ * the table.
+ *
+ * The arrival profiles all put the same total percentage of the day's
+ * voters, 100, in the opening line and the hours:
+ *   flat      the same every hour
+ *   morning   a line at the door, then fewer each hour
+ *   evening   few at first, more each hour
+ *   commute   before work and after work, quiet in the middle
+ *   midday    quiet at the ends, busiest at lunch
+ *
+ * Options:
+ *   --seed=N                 random seed for the files and the configs (19)
+ *   --voters=MIN-MAX         expected voters per precinct (100-8000)
+ *   --voter-dist=DIST        'lognormal' (the default; many small precincts
+ *                            and a long tail of big ones) or 'uniform'
+ *   --stations=MIN-MAX       the precincts' own station counts (1-12)
+ *   --hours=N                hours in the election day (13)
+ *   --iterations=N           iterations per station count (3)
+ *   --service-median=S       median service time in seconds (75)
+ *   --service-spread=X       sigma of the log of the service times (0.8)
+ *   --service-count=N        service times in the table (10000)
+ *
+ * Each precinct's three histogram station counts start at the minimum the
+ * simulation will try for it, so every precinct prints its histograms.
+**/
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <sys/stat.h>
+#include <vector>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+#include "myrandom.h"
+
+static const string kTag = "GEN: ";
+static const int kMinPctCount = 10;
+static const int kMaxPctCount = 100000;
+static const int kTooLongMinutes = 30;
+static const int kShortestService = 10;
+static const int kLongestService = 1000;
+static const double kMinTurnout = 15.0;
+static const double kMaxTurnout = 75.0;
+static const double kMaxMinority = 60.0;
+static const int kHistoCount = 3;
+static const char* const kProfiles[] = {"flat", "morning", "evening",
+                                        "commute", "midday"};
+
+/*******************************************************************************
+ * The settings, from the command line options.
+**/
+struct GenOptions {
+  int seed = 19;
+  int voters_min = 100;
+  int voters_max = 8000;
+  bool voters_lognormal = true;
+  int stations_min = 1;
+  int stations_max = 12;
+  int hours = 13;
+  int iterations = 3;
+  double service_median = 75.0;
+  double service_spread = 0.8;
+  int service_count = 10000;
+};
+
+/*******************************************************************************
+ * Reads 'LOW-HIGH' into 'low' and 'high', exiting if it is not a range.
+**/
+static void ReadRange(const string& option, const string& value,
+                      int& low, int& high) {
+  string::size_type dash = value.find("-", 1);
+  if (dash == string::npos) {
+    cout << kTag << "'" << option << "' needs a range like 100-8000" << endl;
+    exit(1);
+  }
+  low = Utils::StringToInteger(value.substr(0, dash));
+  high = Utils::StringToInteger(value.substr(dash + 1));
+  if ((low <= 0) || (high < low)) {
+    cout << kTag << "bad range in '" << option << "'" << endl;
+    exit(1);
+  }
+}
+
+/*******************************************************************************
+ * Reads the '--name=value' options from 'argv[first_option]' onward. An
+ * unknown one prints the list and exits.
+**/
+static GenOptions ReadGenOptions(int argc, char *argv[], int first_option) {
+  GenOptions options;
+  for (int sub = first_option; sub < argc; ++sub) {
+    string option = static_cast<string>(argv[sub]);
+    string name = option;
+    string value = "";
+
+    string::size_type equals = option.find("=");
+    if (equals != string::npos) {
+      name = option.substr(0, equals);
+      value = option.substr(equals + 1);
+    }
+
+    if ("--seed" == name) {
+      options.seed = Utils::StringToInteger(value);
+    } else if ("--voters" == name) {
+      ReadRange(option, value, options.voters_min, options.voters_max);
+    } else if ("--voter-dist" == name) {
+      if (("lognormal" != value) && ("uniform" != value)) {
+        cout << kTag << "voter distributions: lognormal uniform" << endl;
+        exit(1);
+      }
+      options.voters_lognormal = ("lognormal" == value);
+    } else if ("--stations" == name) {
+      ReadRange(option, value, options.stations_min, options.stations_max);
+    } else if ("--hours" == name) {
+      options.hours = max(1, Utils::StringToInteger(value));
+    } else if ("--iterations" == name) {
+      options.iterations = max(1, Utils::StringToInteger(value));
+    } else if ("--service-median" == name) {
+      options.service_median = max(1, Utils::StringToInteger(value));
+    } else if ("--service-spread" == name) {
+      options.service_spread = max(0.0, stod(value));
+    } else if ("--service-count" == name) {
+      options.service_count = max(1, Utils::StringToInteger(value));
+    } else {
+      cout << kTag << "unknown option '" << option << "'" << endl;
+      cout << kTag << "options: --seed=N --voters=MIN-MAX"
+           << " --voter-dist=DIST --stations=MIN-MAX --hours=N"
+           << " --iterations=N --service-median=S --service-spread=X"
+           << " --service-count=N" << endl;
+      exit(1);
+    }
+  }
+  return options;
+}
+
+/*******************************************************************************
+ * Writes 'count' lognormal service times, clipped to the range a voter
+ * really takes and sorted, to 'filename'.
+ *
+ * Returns:
+ *   the mean of the times written, rounded to a whole second
+**/
+static int WriteServiceTimes(const GenOptions& options, MyRandom& random,
+                             const string& filename) {
+  vector<int> times;
+  double total = 0.0;
+  for (int sub = 0; sub < options.service_count; ++sub) {
+    double seconds = options.service_median
+                     * exp(random.RandomNormal(0.0, options.service_spread));
+    int the_time = static_cast<int>(lround(seconds));
+    the_time = min(kLongestService, max(kShortestService, the_time));
+    times.push_back(the_time);
+    total += the_time;
+  }
+  sort(times.begin(), times.end());
+
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  for (UINT sub = 0; sub < times.size(); ++sub) {
+    out_stream << times.at(sub) << "\n";
+  }
+  Utils::FileClose(out_stream);
+
+  return static_cast<int>(lround(total / times.size()));
+}
+
+/*******************************************************************************
+ * The relative weight of hour 'hour' (0 is the first hour the polls are
+ * open) in a profile, and of the line waiting when they open.
+**/
+static double HourWeight(const string& profile, int hour, int hours) {
+  double place = (hour + 0.5) / hours;
+  if ("morning" == profile)
+    return 1.0 - 0.8 * place;
+  if ("evening" == profile)
+    return 0.2 + 0.8 * place;
+  if ("commute" == profile)
+    return 0.3 + exp(-pow((place - 0.1) / 0.1, 2.0))
+               + exp(-pow((place - 0.85) / 0.1, 2.0));
+  if ("midday" == profile)
+    return 0.2 + exp(-pow((place - 0.5) / 0.2, 2.0));
+  return 1.0;
+}
+
+static double OpeningPercent(const string& profile) {
+  if (("morning" == profile) || ("commute" == profile))
+    return 5.0;
+  return 0.0;
+}
+
+/*******************************************************************************
+ * Writes a configuration with profile 'profile' to 'filename'. The hourly
+ * percentages are rounded to two places, and the last hour takes up the
+ * rounding so that they and the opening line add up to 100.
+**/
+static void WriteConfig(const GenOptions& options, const string& profile,
+                        int service_mean, const string& filename) {
+  double opening = OpeningPercent(profile);
+  vector<double> weights;
+  double total_weight = 0.0;
+  for (int hour = 0; hour < options.hours; ++hour) {
+    weights.push_back(HourWeight(profile, hour, options.hours));
+    total_weight += weights.back();
+  }
+
+  Formatter line;
+  double percent_so_far = opening;
+  line.AppendFixed(opening, 4, 1);
+  for (int hour = 0; hour < options.hours; ++hour) {
+    double percent = round(100.0 * (100.0 - opening) * weights.at(hour)
+                           / total_weight) / 100.0;
+    if (hour == options.hours - 1)
+      percent = 100.0 - percent_so_far;
+    percent_so_far += percent;
+    line.Append(" ");
+    line.AppendFixed(percent, 6, 2);
+  }
+
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  out_stream << options.seed << " " << options.hours << " " << service_mean
+             << " 0 " << options.voters_max << " " << kTooLongMinutes << " "
+             << options.iterations << "\n";
+  out_stream << line.GetString() << "\n";
+  out_stream << "\n";
+  out_stream << "Generated by Gprog with the '" << profile << "' arrival"
+             << " profile\n";
+  out_stream << "\n";
+  out_stream << "LINE ONE\n";
+  out_stream << "RN_seed\n";
+  out_stream << "number of hours in election day\n";
+  out_stream << "time to vote mean (the mean of dataallsorted.txt)\n";
+  out_stream << "minimum number of voters per pct for this simulation\n";
+  out_stream << "maximum number of voters per pct for this simulation\n";
+  out_stream << "waiting time (minutes) considered \"too long\"\n";
+  out_stream << "number of iterations to perform\n";
+  out_stream << "\n";
+  out_stream << "LINE TWO\n";
+  out_stream << "percent at time zero (one number)\n";
+  out_stream << "pct arrival percentages per hour (" << options.hours
+             << " numbers)\n";
+  Utils::FileClose(out_stream);
+}
+
+/*******************************************************************************
+ * Draws one precinct's expected voters.
+**/
+static int DrawExpectedVoters(const GenOptions& options, MyRandom& random) {
+  if (!options.voters_lognormal)
+    return random.RandomUniformInt(options.voters_min, options.voters_max);
+
+  // The median is halfway between the ends on a log scale, and they are two
+  // standard deviations from it
+  double log_min = log(static_cast<double>(options.voters_min));
+  double log_max = log(static_cast<double>(options.voters_max));
+  double log_voters = random.RandomNormal((log_min + log_max) / 2.0,
+                                          (log_max - log_min) / 4.0);
+  int voters = static_cast<int>(lround(exp(log_voters)));
+  return min(options.voters_max, max(options.voters_min, voters));
+}
+
+/*******************************************************************************
+ * Writes 'pct_count' precincts, numbered from 1, to 'filename'.
+ *
+ * Returns:
+ *   the total of the precincts' expected voters
+**/
+static LONG WritePcts(const GenOptions& options, MyRandom& random,
+                      int pct_count, int service_mean,
+                      const string& filename) {
+  LONG total_voters = 0;
+  int number_width = max(3, static_cast<int>(to_string(pct_count).length()));
+  Formatter line;
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  for (int number = 1; number <= pct_count; ++number) {
+    int expected = DrawExpectedVoters(options, random);
+    double turnout = random.RandomUniformDouble(kMinTurnout, kMaxTurnout);
+    int registered = static_cast<int>(lround(expected * 100.0 / turnout));
+    int per_hour = expected / options.hours;
+    int stations = random.RandomUniformInt(options.stations_min,
+                                           options.stations_max);
+    double minority = random.RandomUniformDouble(0.0, kMaxMinority);
+
+    // The same minimum as 'OnePct::RunSimulationPct'
+    int first_histo = expected * service_mean / (options.hours * 3600);
+    first_histo = max(1, first_histo);
+    total_voters += expected;
+
+    line.Clear();
+    string digits = to_string(number);
+    line.Append(string(max(0, number_width
+                              - static_cast<int>(digits.length())), '0'));
+    line.Append(digits);
+    line.Append(" GEN");
+    line.Append(string(6 - min(6, static_cast<int>(digits.length())), '0'));
+    line.Append(digits);
+    line.AppendFixed(turnout, 5, 1);
+    line.AppendInt(registered, 7);
+    line.AppendInt(expected, 7);
+    line.AppendInt(per_hour, 5);
+    line.AppendInt(stations, 3);
+    line.AppendFixed(minority, 5, 1);
+    for (int sub = 0; sub < kHistoCount; ++sub) {
+      line.AppendInt(first_histo + sub, 3);
+    }
+    out_stream << line.GetString() << "\n";
+  }
+  Utils::FileClose(out_stream);
+  return total_voters;
+}
+
+/*******************************************************************************
+ * Main program.
+**/
+int main(int argc, char *argv[]) {
+  Utils::CheckArgsAtLeast(2, argc, argv, "outdir pctcount [options]");
+  string out_dir = static_cast<string>(argv[1]);
+  int pct_count = Utils::StringToInteger(static_cast<string>(argv[2]));
+  GenOptions options = ReadGenOptions(argc, argv, 3);
+
+  if ((pct_count < kMinPctCount) || (pct_count > kMaxPctCount)) {
+    cout << kTag << "the precinct count must be from " << kMinPctCount
+         << " to " << kMaxPctCount << endl;
+    exit(1);
+  }
+  if ((mkdir(out_dir.c_str(), 0755) != 0) && (errno != EEXIST)) {
+    cout << kTag << "cannot make the directory '" << out_dir << "'" << endl;
+    exit(1);
+  }
+
+  // The service times and the precincts each draw from their own stream, so
+  // changing the service options leaves the precincts' random draws alone.
+  // Their histogram station counts still follow the service mean, so
+  // pcts.txt can change with it.
+  MyRandom service_random(options.seed, 0);
+  MyRandom pct_random(options.seed, 1);
+
+  int service_mean = WriteServiceTimes(options, service_random,
+                                       out_dir + "/dataallsorted.txt");
+  LONG total_voters = WritePcts(options, pct_random, pct_count, service_mean,
+                                out_dir + "/pcts.txt");
+  for (const char* profile : kProfiles) {
+    WriteConfig(options, profile, service_mean,
+                out_dir + "/config_" + profile + ".txt");
+  }
+
+  cout << kTag << "wrote " << pct_count << " precincts with "
+       << total_voters << " expected voters, "
+       << options.service_count << " service times (mean "
+       << service_mean << " seconds) and "
+       << (sizeof(kProfiles) / sizeof(kProfiles[0]))
+       << " configurations to '" << out_dir << "'" << endl;
+  return 0;
+}
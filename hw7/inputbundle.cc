@@ -0,0 +1,308 @@
+#include "inputbundle.h"
+/*******************************************************************************
+ * Implementation for the 'InputBundle' class.
+**/
+
+static const string kTag = "BUNDLE: ";
+static const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+
+/*******************************************************************************
+ * Round a byte offset up to the next multiple of 8.
+**/
+static uint64_t AlignTo8(uint64_t offset) {
+  return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+/*******************************************************************************
+ * Constructor.
+**/
+InputBundle::InputBundle() {
+}
+
+/*******************************************************************************
+ * Destructor.
+**/
+InputBundle::~InputBundle() {
+}
+
+/*******************************************************************************
+ * Accessors and mutators.
+**/
+int InputBundle::GetPctCount() const {
+  return static_cast<int>(header_->pct_count);
+}
+
+/*******************************************************************************
+ * Returns a precinct record straight out of the mapped file.
+**/
+const PctRecord& InputBundle::GetPct(int sub) const {
+  assert((sub >= 0) && (sub < this->GetPctCount()));
+  const PctRecord* pcts = reinterpret_cast<const PctRecord*>(
+                          file_.GetData() + header_->pct_offset);
+  return pcts[sub];
+}
+
+/*******************************************************************************
+ * Returns a precinct record after checking it against its own checksum, so
+ * only the records a run reads are ever hashed, and that it comes after the
+ * record before it. A bad one stops the program, as a bad header does in
+ * 'Open'.
+**/
+const PctRecord& InputBundle::ReadPct(int sub) const {
+  const PctRecord& record = this->GetPct(sub);
+  if ((sub > 0) && (this->GetPct(sub - 1).number >= record.number))
+    Fail(filename_, "has precincts out of order at record "
+                    + Utils::Format(sub));
+  const uint64_t* checksums = reinterpret_cast<const uint64_t*>(
+                              file_.GetData() + header_->pct_checksum_offset);
+  if (Checksum(reinterpret_cast<const char*>(&record), sizeof(PctRecord),
+               kFnvOffsetBasis) != checksums[sub])
+    Fail(filename_, "fails the checksum of precinct record "
+                    + Utils::Format(sub));
+  return record;
+}
+
+/*******************************************************************************
+ * Returns the subscript of the first record whose number is at least
+ * 'pct_number', or GetPctCount() if there is none, by binary search. Only the
+ * records probed are read, so the order of the rest is not checked here; the
+ * answer is checked against the record before it, and 'ReadPct' checks each
+ * record that is read after it.
+**/
+int InputBundle::LowerBoundPct(int pct_number) const {
+  int low = 0;
+  int high = this->GetPctCount();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (this->GetPct(mid).number < pct_number)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if ((low > 0) && (this->GetPct(low - 1).number >= pct_number))
+    Fail(filename_, "has precincts out of order at record "
+                    + Utils::Format(low));
+  return low;
+}
+
+/*******************************************************************************
+ * General functions.
+**/
+
+/*******************************************************************************
+ * Function 'IsBundle'.
+ * Returns true if 'filename' is a regular file that starts with the bundle
+ * magic number, so main can tell a bundle from a text config file.
+**/
+bool InputBundle::IsBundle(const string& filename) {
+  MappedFile file;
+  if (!file.Open(filename) || (file.GetSize() < sizeof(kBundleMagic)))
+    return false;
+  return 0 == memcmp(file.GetData(), kBundleMagic, sizeof(kBundleMagic));
+}
+
+/*******************************************************************************
+ * Function 'Open'.
+ * Maps a bundle and checks that it is one this program wrote: the magic
+ * number, version and sizes must agree, the sections must be in order, apart
+ * and 8-byte aligned, and the table checksum must match. Anything else is reported and stops the program, the
+ * same way a missing input file does. The precinct records are not read here;
+ * each is checked when 'ReadPct' reads it.
+**/
+void InputBundle::Open(const string& filename) {
+  if (!file_.Open(filename))
+    Fail(filename, "cannot be mapped");
+  if (file_.GetSize() < sizeof(BundleHeader))
+    Fail(filename, "is too short to be a bundle");
+
+  header_ = reinterpret_cast<const BundleHeader*>(file_.GetData());
+  if (0 != memcmp(header_->magic, kBundleMagic, sizeof(kBundleMagic)))
+    Fail(filename, "is not a bundle");
+  if (kBundleVersion != header_->version)
+    Fail(filename, "is bundle version " + Utils::Format(
+                   static_cast<int>(header_->version)) + ", not " +
+                   Utils::Format(static_cast<int>(kBundleVersion)));
+  if ((sizeof(BundleHeader) != header_->header_bytes) ||
+      (file_.GetSize() - sizeof(BundleHeader) != header_->payload_bytes))
+    Fail(filename, "has the wrong size");
+
+  uint64_t size = file_.GetSize();
+  if ((header_->arrival_offset + header_->arrival_count * sizeof(double)
+       > size) ||
+      (header_->service_offset + header_->service_count * sizeof(int32_t)
+       > size) ||
+      (header_->pct_offset + header_->pct_count * sizeof(PctRecord) > size) ||
+      (header_->pct_checksum_offset + header_->pct_count * sizeof(uint64_t)
+       > size))
+    Fail(filename, "has a section past the end of the file");
+  if ((header_->arrival_offset < sizeof(BundleHeader)) ||
+      (header_->arrival_offset + header_->arrival_count * sizeof(double)
+       > header_->service_offset) ||
+      (header_->service_offset + header_->service_count * sizeof(int32_t)
+       > header_->pct_offset) ||
+      (header_->pct_offset + header_->pct_count * sizeof(PctRecord)
+       > header_->pct_checksum_offset))
+    Fail(filename, "has its sections out of order or overlapping");
+  if ((header_->arrival_offset != AlignTo8(header_->arrival_offset)) ||
+      (header_->service_offset != AlignTo8(header_->service_offset)) ||
+      (header_->pct_offset != AlignTo8(header_->pct_offset)) ||
+      (header_->pct_checksum_offset
+       != AlignTo8(header_->pct_checksum_offset)))
+    Fail(filename, "has a section that is not 8-byte aligned");
+
+  if (TableChecksum(file_.GetData()) != header_->table_checksum)
+    Fail(filename, "fails its checksum");
+  filename_ = filename;
+
+  cout << kTag << "mapped bundle '" << filename << "' with "
+       << header_->pct_count << " precincts\n";
+}
+
+/*******************************************************************************
+ * Function 'Close'.
+**/
+void InputBundle::Close() {
+  file_.Close();
+  header_ = nullptr;
+}
+
+/*******************************************************************************
+ * Function 'ReadConfiguration'.
+ * Sets everything Configuration::ReadConfiguration reads from the config
+ * file and from "dataallsorted.txt".
+**/
+void InputBundle::ReadConfiguration(Configuration& config) const {
+  config.seed_ = header_->seed;
+  config.election_day_length_hours_ = header_->election_day_length_hours;
+  config.election_day_length_seconds_ = config.election_day_length_hours_
+                                        * 3600;
+  config.time_to_vote_mean_seconds_ = header_->time_to_vote_mean_seconds;
+  config.min_expected_to_simulate_ = header_->min_expected_to_simulate;
+  config.max_expected_to_simulate_ = header_->max_expected_to_simulate;
+  config.wait_time_minutes_that_is_too_long_ =
+    header_->wait_time_minutes_that_is_too_long;
+  config.number_of_iterations_ = header_->number_of_iterations;
+  config.arrival_zero_ = header_->arrival_zero;
+
+  const double* arrivals = reinterpret_cast<const double*>(
+                           file_.GetData() + header_->arrival_offset);
+  config.arrival_fractions_.assign(arrivals,
+                                   arrivals + header_->arrival_count);
+
+  const int32_t* services = reinterpret_cast<const int32_t*>(
+                            file_.GetData() + header_->service_offset);
+  config.actual_service_times_.assign(services,
+                                      services + header_->service_count);
+}
+
+/*******************************************************************************
+ * Function 'Write'.
+ * Lays out the header and the sections in one buffer, checksums the tables
+ * and each precinct record, and writes the whole thing at once. The precincts
+ * are sorted by number, which 'LowerBoundPct' depends on, and two with the
+ * same number stop the program, so every bundle written is in strict order.
+**/
+void InputBundle::Write(const string& filename, const Configuration& config,
+                        vector<PctRecord> pcts) {
+  sort(pcts.begin(), pcts.end(),
+       [](const PctRecord& a, const PctRecord& b) {
+         return a.number < b.number;
+       });
+  for (UINT sub = 1; sub < pcts.size(); ++sub) {
+    if (pcts.at(sub - 1).number == pcts.at(sub).number)
+      Fail(filename, "cannot hold two precincts numbered "
+                     + Utils::Format(pcts.at(sub).number));
+  }
+
+  BundleHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kBundleMagic, sizeof(kBundleMagic));
+  header.version = kBundleVersion;
+  header.header_bytes = sizeof(BundleHeader);
+
+  header.seed = config.seed_;
+  header.election_day_length_hours = config.election_day_length_hours_;
+  header.time_to_vote_mean_seconds = config.time_to_vote_mean_seconds_;
+  header.min_expected_to_simulate = config.min_expected_to_simulate_;
+  header.max_expected_to_simulate = config.max_expected_to_simulate_;
+  header.wait_time_minutes_that_is_too_long =
+    config.wait_time_minutes_that_is_too_long_;
+  header.number_of_iterations = config.number_of_iterations_;
+  header.arrival_zero = config.arrival_zero_;
+
+  header.arrival_count = config.arrival_fractions_.size();
+  header.service_count = config.actual_service_times_.size();
+  header.pct_count = pcts.size();
+  header.arrival_offset = AlignTo8(sizeof(BundleHeader));
+  header.service_offset = AlignTo8(header.arrival_offset
+                                   + header.arrival_count * sizeof(double));
+  header.pct_offset = AlignTo8(header.service_offset
+                               + header.service_count * sizeof(int32_t));
+  header.pct_checksum_offset = AlignTo8(header.pct_offset
+                                        + header.pct_count * sizeof(PctRecord));
+  uint64_t total_bytes = header.pct_checksum_offset
+                         + header.pct_count * sizeof(uint64_t);
+  header.payload_bytes = total_bytes - sizeof(BundleHeader);
+
+  vector<char> buffer(total_bytes, 0);
+  memcpy(&buffer[header.arrival_offset], config.arrival_fractions_.data(),
+         header.arrival_count * sizeof(double));
+  for (UINT sub = 0; sub < config.actual_service_times_.size(); ++sub) {
+    int32_t service = config.actual_service_times_.at(sub);
+    memcpy(&buffer[header.service_offset + sub * sizeof(int32_t)], &service,
+           sizeof(int32_t));
+  }
+  if (!pcts.empty())
+    memcpy(&buffer[header.pct_offset], pcts.data(),
+           header.pct_count * sizeof(PctRecord));
+  for (UINT sub = 0; sub < pcts.size(); ++sub) {
+    uint64_t checksum = Checksum(reinterpret_cast<const char*>(&pcts.at(sub)),
+                                 sizeof(PctRecord), kFnvOffsetBasis);
+    memcpy(&buffer[header.pct_checksum_offset + sub * sizeof(uint64_t)],
+           &checksum, sizeof(uint64_t));
+  }
+
+  memcpy(&buffer[0], &header, sizeof(BundleHeader));
+  header.table_checksum = TableChecksum(&buffer[0]);
+  memcpy(&buffer[0], &header, sizeof(BundleHeader));
+
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  out_stream.write(&buffer[0], buffer.size());
+  Utils::FileClose(out_stream);
+}
+
+/*******************************************************************************
+ * 64-bit FNV-1a hash of a block of bytes, continuing from 'hash'.
+**/
+uint64_t InputBundle::Checksum(const char* data, size_t size, uint64_t hash) {
+  for (size_t sub = 0; sub < size; ++sub) {
+    hash ^= static_cast<unsigned char>(data[sub]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/*******************************************************************************
+ * The checksum of the header, with 'table_checksum' taken as zero, and of the
+ * arrival fractions and service times after it, for a bundle starting at
+ * 'data' whose header has been checked against the file's size.
+**/
+uint64_t InputBundle::TableChecksum(const char* data) {
+  BundleHeader header;
+  memcpy(&header, data, sizeof(BundleHeader));
+  header.table_checksum = 0;
+  uint64_t hash = Checksum(reinterpret_cast<const char*>(&header),
+                           sizeof(BundleHeader), kFnvOffsetBasis);
+  return Checksum(data + sizeof(BundleHeader),
+                  header.pct_offset - sizeof(BundleHeader), hash);
+}
+
+/*******************************************************************************
+ * Report a bad bundle and stop.
+**/
+void InputBundle::Fail(const string& filename, const string& why) {
+  cout << kTag << "ERROR: '" << filename << "' " << why << endl;
+  Utils::log_stream << kTag << "ERROR: '" << filename << "' " << why << endl;
+  exit(0);
+}
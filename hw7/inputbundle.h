@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * Header for the 'InputBundle' class.
+ *
+ * An input bundle is one binary file holding everything Aprog reads at
+ * startup: the Configuration fields, the service times that otherwise come
+ * from "dataallsorted.txt", and one PctRecord per precinct. It is written
+ * once by running Aprog with '--compile=FILE' and is then given to Aprog in
+ * place of the config file. The bundle is mapped read-only, so starting up is
+ * a check of the header and the small tables before the precincts, whatever
+ * the number of precincts, and every process using the same bundle shares its
+ * pages through the page cache.
+ *
+ * Layout (native byte order, every section aligned to 8 bytes):
+ *   BundleHeader
+ *   double   arrival_fractions[arrival_count]
+ *   int32_t  service_times[service_count]
+ *   PctRecord pcts[pct_count]
+ *   uint64_t pct_checksums[pct_count]
+ * The checksums are 64-bit FNV-1a. 'table_checksum' covers the header (with
+ * itself zeroed), the arrival fractions and the service times, and is checked
+ * by 'Open'. Each precinct record has its own checksum, checked by 'ReadPct'
+ * when the record is read.
+ *
+ * The precinct records are fixed size and sorted by precinct number, so the
+ * records are their own index: 'LowerBoundPct' finds a precinct, or the start
+ * of a range of them, by binary search. 'Write' is what guarantees the order;
+ * opening a bundle reads none of the records, and a run reads only the ones
+ * the search probes, the ones it simulates and the record before each of
+ * those, checking the order and checksums of the ones it reads as it goes.
+**/
+
+#ifndef INPUTBUNDLE_H
+#define INPUTBUNDLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../Utilities/mappedfile.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+#include "configuration.h"
+#include "onepct.h"
+
+static const char kBundleMagic[8] = {'A', 'P', 'R', 'O', 'G', 'B', 'N', 'D'};
+static const uint32_t kBundleVersion = 2;
+
+struct BundleHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_bytes;
+  uint64_t payload_bytes;
+  uint64_t table_checksum;
+
+  int32_t seed;
+  int32_t election_day_length_hours;
+  int32_t time_to_vote_mean_seconds;
+  int32_t min_expected_to_simulate;
+  int32_t max_expected_to_simulate;
+  int32_t wait_time_minutes_that_is_too_long;
+  int32_t number_of_iterations;
+  int32_t unused;
+  double arrival_zero;
+
+  uint64_t arrival_offset;
+  uint64_t arrival_count;
+  uint64_t service_offset;
+  uint64_t service_count;
+  uint64_t pct_offset;
+  uint64_t pct_count;
+  uint64_t pct_checksum_offset;
+};
+
+class InputBundle {
+public:
+/*******************************************************************************
+ * Constructors and destructors for the class.
+**/
+ InputBundle();
+ virtual ~InputBundle();
+
+/*******************************************************************************
+ * Accessors and Mutators.
+**/
+ int GetPctCount() const;
+ const PctRecord& GetPct(int sub) const;
+ // The same record, after checking it against its checksum
+ const PctRecord& ReadPct(int sub) const;
+ // Subscript of the first record numbered pct_number or more
+ int LowerBoundPct(int pct_number) const;
+
+/*******************************************************************************
+ * General functions.
+**/
+ // Returns true if the file starts with the bundle magic number
+ static bool IsBundle(const string& filename);
+ // Maps a bundle and checks its version, sizes and table checksum
+ void Open(const string& filename);
+ void Close();
+ // Fills in everything ReadConfiguration would have read
+ void ReadConfiguration(Configuration& config) const;
+ // Writes a bundle of the configuration and the precinct records, sorted
+ static void Write(const string& filename, const Configuration& config,
+                   vector<PctRecord> pcts);
+
+private:
+ MappedFile file_;
+ const BundleHeader* header_ = nullptr;
+ string filename_ = "";
+
+ static uint64_t Checksum(const char* data, size_t size, uint64_t hash);
+ static uint64_t TableChecksum(const char* data);
+ static void Fail(const string& filename, const string& why);
+};
+
+#endif // INPUTBUNDLE_H
@@ -27,6 +27,7 @@ int main(int argc, char *argv[]) {
 
   Scanner config_stream;
   Scanner pct_stream;
+  PctTable pct_table;
 
   Configuration config;
   Simulation simulation;
@@ -36,8 +37,9 @@ int main(int argc, char *argv[]) {
   cout<< kTag << "Beginning execution" << endl;
   
 
-  Utils::CheckArgs(4, argc, argv,
-                   "configfilename pctfilename outfilename logfilename");
+  Utils::CheckArgsAtLeast(4, argc, argv,
+                          "configfilename pctfilename outfilename logfilename"
+                          " [--name=value ...]");
   config_filename = static_cast<string>(argv[1]);
   pct_filename = static_cast<string>(argv[2]);
   out_filename = static_cast<string>(argv[3]);
@@ -46,8 +48,8 @@ int main(int argc, char *argv[]) {
   Utils::FileOpen(out_stream, out_filename);
   Utils::LogFileOpen(log_filename);
 
+  ScopedTimer::StartClock();
   outstring = kTag + "Beginning execution\n";
-  outstring.append(kTag + Utils::TimeCall("beginning"));
   out_stream << outstring << endl;
   Utils::log_stream << outstring << endl;
 
@@ -61,9 +63,36 @@ int main(int argc, char *argv[]) {
    * and mean and dev voting time
  **/
   
-  config_stream.OpenFile(config_filename);
-  config.ReadConfiguration(config_stream);
-  config_stream.Close();
+  /*******************************************************************************
+   * an input bundle given as the config file holds the precincts too,
+   * so the pct file is not read
+ **/
+  
+  InputBundle bundle;
+  bool from_bundle = InputBundle::IsBundle(config_filename);
+  if (from_bundle) {
+    bundle.Open(config_filename);
+    bundle.ReadConfiguration(config);
+  } else {
+    config_stream.OpenFile(config_filename);
+    config.ReadConfiguration(config_stream);
+    config_stream.Close();
+  }
+  config.ReadOptions(argc, argv, 5);
+  if (config.perf_counters_)
+    ScopedTimer::EnablePerfCounters();
+  if (config.alloc_stats_ && AllocStats::IsHooked()) {
+    AllocStats::Enable();
+  } else if (config.alloc_stats_) {
+    outstring = kTag + "--alloc-stats counts only in Aprog-alloc; ignored\n";
+    Utils::Output(outstring, out_stream, Utils::log_stream);
+  }
+  if (config.profile_filename_ != "")
+    Profiler::Start(config.profile_hz_);
+  if (config.chrome_trace_filename_ != "") {
+    EventTrace::Enable(kEventTraceCapacity);
+    EventTrace::NameThread("main");
+  }
 
   outstring = kTag + config.ToString() + "\n";
   out_stream << outstring << endl;
@@ -71,26 +100,87 @@ int main(int argc, char *argv[]) {
 
   random = MyRandom(config.seed_);
 
+  // The pipeline reads the precincts itself, as it simulates them
+  bool pipelined = config.pipeline_ && !from_bundle &&
+                   (config.compile_filename_ == "");
+
   /*******************************************************************************
    * now read the precinct data
  **/
   
-  pct_stream.OpenFile(pct_filename);
-  simulation.ReadPrecincts(pct_stream);
-  pct_stream.Close();
+  {
+    ScopedTimer read_timer("read");
+    if (from_bundle) {
+      outstring = kTag + "precincts from bundle '" + config_filename + "', '"
+                  + pct_filename + "' not read\n";
+      Utils::Output(outstring, out_stream, Utils::log_stream);
+      simulation.ReadPrecincts(bundle, config);
+      bundle.Close();
+    } else if (pipelined) {
+      // RunPipeline reads the file as it goes
+    } else if ((config.thread_count_ > 1) &&
+               pct_table.ReadFile(pct_filename, config.thread_count_)) {
+      simulation.ReadPrecincts(pct_table, config);
+    } else {
+      pct_stream.OpenFile(pct_filename);
+      simulation.ReadPrecincts(pct_stream, config);
+      pct_stream.Close();
+    }
+  }
 
   /*******************************************************************************
-   * here is the real work
+   * here is the real work, unless we were only asked to compile a bundle
  **/
   
-  simulation.RunSimulation(config, random, out_stream);
+  // The tee writes only text that both files get, so not if their
+  // verbosities make them different
+  if (config.tee_output_ && (config.out_verbosity_ == config.log_verbosity_))
+    Utils::StartTeeOutput(out_stream, out_filename, Utils::log_stream,
+                          log_filename);
+  if (config.async_output_bytes_ > 0)
+    Utils::StartAsyncOutput(config.async_output_bytes_);
+
+  if (config.metrics_filename_ != "")
+    RunMetrics::Start(config.metrics_filename_, config.metrics_seconds_,
+                      pipelined ? config.thread_count_ : 1);
+
+  {
+    ScopedTimer run_timer("run");
+    if (config.compile_filename_ != "") {
+      InputBundle::Write(config.compile_filename_, config,
+                         simulation.GetPctRecords());
+      outstring = kTag + "wrote input bundle '" + config.compile_filename_
+                  + "'\n";
+      Utils::Output(outstring, out_stream, Utils::log_stream);
+    } else if (pipelined) {
+      simulation.RunPipeline(config, pct_filename, out_stream);
+    } else {
+      simulation.RunSimulation(config, random, out_stream);
+    }
+  }
+
+  RunMetrics::Stop();
+  Profiler::Stop();
+
+  // main writes to the streams directly again from here on
+  Utils::StopAsyncOutput();
+  Utils::StopTeeOutput();
 
   /*******************************************************************************
    * close up and go home
   **/
   
+  if (config.chrome_trace_filename_ != "") {
+    outstring = kTag + EventTrace::Write(config.chrome_trace_filename_);
+    Utils::Output(outstring, out_stream, Utils::log_stream);
+  }
+  if (config.profile_filename_ != "") {
+    outstring = kTag + Profiler::Write(config.profile_filename_);
+    Utils::Output(outstring, out_stream, Utils::log_stream);
+  }
+
   outstring = kTag + "Ending execution" + "\n";
-  outstring.append(kTag + Utils::TimeCall("ending"));
+  outstring.append(kTag + ScopedTimer::Report(kTimerTopCount));
   out_stream << outstring << endl;
   Utils::log_stream << outstring << endl;
 
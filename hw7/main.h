@@ -14,6 +14,10 @@
 #ifndef MAIN_H
 #define MAIN_H
 
+#include "../Utilities/allocstats.h"
+#include "../Utilities/eventtrace.h"
+#include "../Utilities/profiler.h"
+#include "../Utilities/scopedtimer.h"
 #include "../Utilities/utils.h"
 #include "../Utilities/scanner.h"
 #include "../Utilities/scanline.h"
@@ -21,9 +25,15 @@
 using namespace std;
 
 #include "configuration.h"
+#include "inputbundle.h"
 #include "simulation.h"
 #include "myrandom.h"
+#include "runmetrics.h"
 
 static const string kDummyFilename = "XX";
+// How many of the longest precincts (and other labels) the timing lists
+static const int kTimerTopCount = 10;
+// Events each thread keeps for '--chrome-trace'; older ones are dropped
+static const int kEventTraceCapacity = 1 << 16;
 
 #endif // MAIN_H
@@ -36,6 +36,17 @@ MyRandom::MyRandom(unsigned seed) {
   generator_.seed(seed_);
 }
 
+/*******************************************************************************
+ * Constructor for one of many independent streams from the same seed. The
+ * seed and the stream number are mixed through 'seed_seq' so that streams
+ * 0, 1, 2, ... do not start from nearby Mersenne Twister states.
+**/
+MyRandom::MyRandom(unsigned seed, unsigned stream) {
+  seed_ = seed;
+  std::seed_seq sequence = {seed, stream};
+  generator_.seed(sequence);
+}
+
 /*******************************************************************************
  * Destructor
 **/
@@ -28,6 +28,7 @@ class MyRandom {
 public:
  MyRandom();
  MyRandom(unsigned seed);
+ MyRandom(unsigned seed, unsigned stream);
  virtual ~MyRandom();
 
  int RandomExponentialInt(double mean);
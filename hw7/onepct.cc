@@ -49,6 +49,40 @@ int OnePct::GetPctNumber() const {
   return pct_number_;
 }
 
+/*******************************************************************************
+**/
+
+const string& OnePct::GetPctName() const {
+  return pct_name_;
+}
+
+/*******************************************************************************
+ * Returns the wait times over all iterations of the last station count
+ * simulated, which is the count the precinct ends up needing.
+**/
+
+const QuantileSketch& OnePct::GetFinalWaitSketch() const {
+  return final_wait_sketch_;
+}
+
+/*******************************************************************************
+ * Returns the numbers behind each per-iteration line of the last simulation,
+ * which are kept only if config.results_filename_ is set.
+**/
+
+const vector<ResultRow>& OnePct::GetResults() const {
+  return results_;
+}
+
+/*******************************************************************************
+ * Sets where the voter trace is written, which is used only if
+ * config.trace_filename_ is set. Each block is written as it is closed.
+**/
+
+void OnePct::SetTraceSink(ostream* sink) {
+  trace_.SetSink(sink);
+}
+
 /*******************************************************************************
 * General functions.
 *
@@ -57,41 +91,25 @@ int OnePct::GetPctNumber() const {
 * Function 'ComputeMeanAndDev()
 * Computes the mean and the standard deviation of the waiting times and sets
 * wait_mean_senconds_ and wait_dev_seconds_
+*
+* The mean is the sum of the waits divided by pct_expected_voters_ (not by
+* the number of voters), and the deviation is measured about that mean and
+* also divided by pct_expected_voters_. The accumulator has the exact sum and
+* the squares about the true mean (M2); with N voters, true mean m, and
+* reported mean r, the squares about r add up to M2 + N*(m - r)^2.
 **/
 
-void OnePct::ComputeMeanAndDev() {
-  int sum_of_wait_times_seconds = 0;
-  double sum_of_adjusted_times_seconds = 0.0;
-  // Unnecessary code: sum_of_wait_times_seconds = 0;
-  multimap<int, OneVoter>::iterator iter_multimap;
-
-  // Sum the waiting times
-  for (iter_multimap = voters_done_voting_.begin();
-       iter_multimap != voters_done_voting_.end(); ++iter_multimap) {
-    OneVoter voter = iter_multimap->second;
-
-    sum_of_wait_times_seconds += voter.GetTimeWaiting();
-  }
+void OnePct::ComputeMeanAndDev(const Accumulator& wait_stats) {
+  double count = static_cast<double>(wait_stats.GetCount());
+  double expected = static_cast<double>(pct_expected_voters_);
 
   // Set wait mean
-  wait_mean_seconds_ = static_cast<double>(sum_of_wait_times_seconds)
-                       / static_cast<double>(pct_expected_voters_);
-  // Unecessary code: sum_of_adjusted_times_seconds = 0.0;
-
-  // Sum the square of the waiting times - mean waiting time
-  for (iter_multimap = voters_done_voting_.begin();
-       iter_multimap != voters_done_voting_.end(); ++iter_multimap) {
-
-    OneVoter voter = iter_multimap->second;
-    double this_addin = static_cast<double>(voter.GetTimeWaiting())
-                      - wait_mean_seconds_;
-
-    sum_of_adjusted_times_seconds += this_addin * this_addin;
-  }
+  wait_mean_seconds_ = static_cast<double>(wait_stats.GetSum()) / expected;
 
   // Set wait standard deviation
-  wait_dev_seconds_ = sqrt(sum_of_adjusted_times_seconds
-                    / static_cast<double>(pct_expected_voters_));
+  double shift = wait_stats.GetMean() - wait_mean_seconds_;
+  wait_dev_seconds_ = sqrt((wait_stats.GetM2() + count * shift * shift)
+                           / expected);
 }
 
 /*******************************************************************************
@@ -111,14 +129,19 @@ void OnePct::ComputeMeanAndDev() {
  * though it is the same process.
 **/
 
-void OnePct::CreateVoters(const Configuration& config, MyRandom& random,
-                          ofstream& out_stream) {
+void OnePct::CreateVoters(const Configuration& config, MyRandom& random) {
+  ScopedTimer timer("CreateVoters");
   int duration = 0;
   int arrival = 0;
   int sequence = 0;
   double percent = 0.0;
   string outstring = "XX";
 
+  if (config.hourly_voter_streams_) {
+    this->CreateVotersHourly(config, random);
+    return;
+  }
+
   voters_backup_.clear();
   // Unnecessary code: sequence = 0;
 
@@ -173,94 +196,312 @@ void OnePct::CreateVoters(const Configuration& config, MyRandom& random,
   }
 }
 
+/*******************************************************************************
+ * Function: 'CreateVotersHourly'
+ * Generates the same kind of voters as CreateVoters, but each block of
+ * voters (the voters at time zero, then each hour of the day) comes from its
+ * own random stream, so the blocks can be generated on separate threads.
+ *
+ * How many voters are in each block depends only on the arrival fractions
+ * and pct_expected_voters_, so a prefix sum of the block counts gives every
+ * block its own slice of one array and its own range of sequence numbers,
+ * the same ones CreateVoters would hand out. The streams are seeded from one
+ * draw of 'random', so every iteration still gets different voters.
+ *
+ * Each slice comes out in arrival order. An hour's last arrivals can spill
+ * past the start of the next hour, so neighbouring slices are merged where
+ * they overlap before the voters are put in voters_backup_.
+**/
+
+void OnePct::CreateVotersHourly(const Configuration& config,
+                                MyRandom& random) {
+  int hours = config.election_day_length_hours_;
+  vector<int> block_counts = this->HourlyBlockCounts(config);
+
+  vector<int> block_offsets(1, 0);
+  for (UINT block = 0; block < block_counts.size(); ++block) {
+    block_offsets.push_back(block_offsets.back() + block_counts.at(block));
+  }
+
+  vector<OneVoter> voters(block_offsets.back());
+  unsigned stream_seed = random.RandomUniformInt(0, INT_MAX);
+
+  Utils::ParallelFor(hours + 1, config.thread_count_, [&](int block) {
+    MyRandom block_random(stream_seed, block);
+    int sequence = block_offsets.at(block);
+    int arrival = (0 == block) ? 0 : (block - 1) * 3600;
+    double lambda = static_cast<double>(block_counts.at(block) / 3600.0);
+
+    for (int voter = 0; voter < block_counts.at(block); ++voter) {
+      if (block > 0)
+        arrival += block_random.RandomExponentialInt(lambda);
+
+      int duration_sub = block_random.RandomUniformInt(0,
+                                               config.GetMaxServiceSubscript());
+      int duration = config.actual_service_times_.at(duration_sub);
+      voters.at(sequence) = OneVoter(sequence, arrival, duration);
+      ++sequence;
+    }
+  });
+
+  // Merge each slice into the sorted voters before it, touching only the
+  // earlier voters who arrive after this slice's first voter
+  auto by_arrival = [](const OneVoter& a, const OneVoter& b) {
+    return a.GetTimeArrival() < b.GetTimeArrival();
+  };
+  for (int block = 1; block <= hours; ++block) {
+    auto middle = voters.begin() + block_offsets.at(block);
+    auto end = voters.begin() + block_offsets.at(block + 1);
+    if (middle == end)
+      continue;
+    auto overlap = upper_bound(voters.begin(), middle, *middle, by_arrival);
+    inplace_merge(overlap, middle, end, by_arrival);
+  }
+
+  voters_backup_.clear();
+  for (auto iter = voters.begin(); iter != voters.end(); ++iter) {
+    voters_backup_.insert(voters_backup_.end(),
+                          std::pair<int, OneVoter>(iter->GetTimeArrival(),
+                                                   *iter));
+  }
+}
+
+/*******************************************************************************
+ * Function: 'HourlyBlockCounts'
+ * Returns how many voters CreateVoters makes in each block: block 0 is the
+ * voters at time zero and block hour+1 is that hour's voters.
+**/
+
+vector<int> OnePct::HourlyBlockCounts(const Configuration& config) const {
+  vector<int> block_counts;
+
+  block_counts.push_back(round((config.arrival_zero_ / 100.0)
+                               * pct_expected_voters_));
+  for (int hour = 0; hour < config.election_day_length_hours_; ++hour) {
+    double percent = config.arrival_fractions_.at(hour);
+    int voters_this_hour = round((percent / 100.0) * pct_expected_voters_);
+
+    // Same extra voter as CreateVoters
+    if (0 == hour%2)
+      ++voters_this_hour;
+    block_counts.push_back(voters_this_hour);
+  }
+
+  return block_counts;
+}
+
+/*******************************************************************************
+ * Function: 'RunSimulationPctStreaming'
+ * Simulates one iteration without ever holding the whole day's voters.
+ *
+ * The voters are the ones CreateVotersHourly would make, block by block from
+ * the same streams, but each block only generates its next voter when the
+ * one before it has been taken. The blocks are merged by arrival time (ties
+ * go to the lower block, which has the lower sequence numbers), so voters
+ * come out in the same order as voters_backup_.
+ *
+ * Waits only depend on when stations come free, not on which station, so the
+ * stations are just a heap of free times, carrying their numbers only for the
+ * voter trace. Voters are served first come first served, each starting at
+ * the latest of its arrival, the previous start, and the earliest free
+ * station. This is the rule RunSimulationPct2 follows a second at a time. The
+ * wait is added to 'wait_stats' and 'wait_sketch' as soon as the voter
+ * starts, and goes into the trace, numbered in arrival order, if there is
+ * one; then the voter is dropped. Memory is one entry per station and per
+ * block, however many voters there are.
+**/
+
+void OnePct::RunSimulationPctStreaming(const Configuration& config,
+                                       MyRandom& random, int stations_count,
+                                       Accumulator& wait_stats,
+                                       QuantileSketch& wait_sketch) {
+  ScopedTimer timer("RunSimulationPctStreaming");
+  vector<int> block_counts = this->HourlyBlockCounts(config);
+  int block_count = static_cast<int>(block_counts.size());
+  unsigned stream_seed = random.RandomUniformInt(0, INT_MAX);
+
+  vector<MyRandom> block_randoms;
+  vector<int> block_remaining(block_counts);
+  vector<int> block_arrival(block_count, 0);
+  vector<int> block_duration(block_count, 0);
+  for (int block = 0; block < block_count; ++block) {
+    block_randoms.push_back(MyRandom(stream_seed, block));
+    if (block > 0)
+      block_arrival.at(block) = (block - 1) * 3600;
+  }
+
+  // Draw the next voter of a block, in the same order as CreateVotersHourly
+  auto next_of_block = [&](int block) {
+    if (block > 0) {
+      double lambda = static_cast<double>(block_counts.at(block) / 3600.0);
+      block_arrival.at(block) +=
+        block_randoms.at(block).RandomExponentialInt(lambda);
+    }
+    int duration_sub = block_randoms.at(block).RandomUniformInt(0,
+                                               config.GetMaxServiceSubscript());
+    block_duration.at(block) = config.actual_service_times_.at(duration_sub);
+    --block_remaining.at(block);
+  };
+
+  // Heads of the blocks, earliest arrival first, lower block first on ties
+  priority_queue<pair<int, int>, vector<pair<int, int> >,
+                 greater<pair<int, int> > > heads;
+  for (int block = 0; block < block_count; ++block) {
+    if (block_remaining.at(block) > 0) {
+      next_of_block(block);
+      heads.push(make_pair(block_arrival.at(block), block));
+    }
+  }
+
+  // Every station starts free at time zero
+  priority_queue<pair<int, int>, vector<pair<int, int> >,
+                 greater<pair<int, int> > > station_free_times;
+  for (int i = 0; i < stations_count; ++i) {
+    station_free_times.push(make_pair(0, i));
+  }
+
+  bool tracing = (config.trace_filename_ != "");
+  int sequence = 0;
+  int previous_start = 0;
+
+  while (!heads.empty()) {
+    int block = heads.top().second;
+    int arrival = heads.top().first;
+    int duration = block_duration.at(block);
+    heads.pop();
+    if (block_remaining.at(block) > 0) {
+      next_of_block(block);
+      heads.push(make_pair(block_arrival.at(block), block));
+    }
+
+    int station = station_free_times.top().second;
+    int start = max(max(arrival, previous_start),
+                    station_free_times.top().first);
+    station_free_times.pop();
+    station_free_times.push(make_pair(start + duration, station));
+    previous_start = start;
+
+    wait_stats.Add(start - arrival);
+    wait_sketch.Add(start - arrival);
+    if (tracing)
+      trace_.AddVoter(sequence, arrival, start, duration, station);
+    ++sequence;
+  }  // while (!heads.empty()) {
+  ScopedTimer::CountItems(sequence);
+}
+
 /*******************************************************************************
  * Function DoStatistics
  * Returns the number of voters that waited beyond an ideal time.
  *
  * Additionally:
- * Scrapes the waiting times in minutes for histogram, and calculates the
+ * Scrapes the waiting times for the histogram, and calculates the
  * number of voters that waited beyond an ideal wait time. The results are
- * Printed in a formatted manner
+ * Printed in a formatted manner, followed at kVerbosePerVoter by every voter.
 **/
 
 int OnePct::DoStatistics(int iteration, const Configuration& config,
-                          int station_count, map<int, int>& map_for_histo,
-                          ofstream& out_stream) {
-  string outstring = "\n";
-  map<int, int> wait_time_minutes_map;
+                          int station_count, Accumulator& histo_stats,
+                          QuantileSketch& histo_sketch, ReportSink& report) {
+  ScopedTimer timer("DoStatistics");
+  Accumulator wait_stats(kHistoMinutes, 60);
+  QuantileSketch wait_sketch;
 
 /*******************************************************************************
- * Calculate how many minutes each voter had to wait. Store to histo map and
- * wait_time_minutes_map
+ * Add how long each voter had to wait to wait_stats, binned by minute, and to
+ * wait_sketch for the quantiles
 **/
   multimap<int, OneVoter>::iterator iter_multimap;
 
   for (iter_multimap = this->voters_done_voting_.begin();
        iter_multimap != this->voters_done_voting_.end(); ++iter_multimap) {
-    OneVoter voter = iter_multimap->second;
-    // Turn Seconds to minutes
-    int wait_time_minutes = voter.GetTimeWaiting() / 60;
-
-    ++(wait_time_minutes_map[wait_time_minutes]);
-    ++(map_for_histo[wait_time_minutes]);
+    wait_stats.Add(iter_multimap->second.GetTimeWaiting());
+    wait_sketch.Add(iter_multimap->second.GetTimeWaiting());
   }
 
+  int toolongcount = ReportStatistics(iteration, config, station_count,
+                                      wait_stats, wait_sketch, histo_stats,
+                                      histo_sketch, report);
+
+  report.Emit(kVerbosePerVoter, [&](Formatter& lines) {
+    string label = kTag + "VOTERS ITERATION " + to_string(iteration);
+    AppendVoterMap(lines, label, voters_done_voting_);
+  });
+
+  return toolongcount;
+}  //End OnePct::DoStatistics{...}
+
 /*******************************************************************************
- * For each waitime observed, calculate how many waited longer than desired
- * wait time, desired time + 10, and + 20
+ * Function ReportStatistics
+ * Returns the number of voters that waited beyond an ideal time.
+ *
+ * Given one iteration's waits in 'wait_stats' and 'wait_sketch', sets the
+ * mean and deviation, merges the waits into the histogram and sketch for
+ * this station count, calculates the number of voters that waited beyond an
+ * ideal wait time, and prints the results, with the wait quantiles, in a
+ * formatted manner. The line is only formatted if 'report' wants
+ * kVerbosePerIteration.
 **/
 
-  int toolongcount = 0;
-  int toolongcountplus10 = 0;
-  int toolongcountplus20 = 0;
+int OnePct::ReportStatistics(int iteration, const Configuration& config,
+                             int station_count,
+                             const Accumulator& wait_stats,
+                             const QuantileSketch& wait_sketch,
+                             Accumulator& histo_stats,
+                             QuantileSketch& histo_sketch,
+                             ReportSink& report) {
+  ComputeMeanAndDev(wait_stats);
+  histo_stats.Merge(wait_stats);
+  histo_sketch.Merge(wait_sketch);
 
-  for (auto iter = wait_time_minutes_map.rbegin();
-       iter != wait_time_minutes_map.rend(); ++iter) {
-    int waittime = iter->first;
-    int waitcount = iter->second;
-
-    if (waittime > config.wait_time_minutes_that_is_too_long_)
-      toolongcount += waitcount;
+/*******************************************************************************
+ * Calculate how many waited longer than desired wait time, desired time + 10,
+ * and + 20 minutes
+**/
 
-    if (waittime > config.wait_time_minutes_that_is_too_long_+10)
-      toolongcountplus10 += waitcount;
+  vector<int> thresholds;
+  thresholds.push_back(config.wait_time_minutes_that_is_too_long_);
+  thresholds.push_back(config.wait_time_minutes_that_is_too_long_ + 10);
+  thresholds.push_back(config.wait_time_minutes_that_is_too_long_ + 20);
+  vector<LONG> too_long_counts = wait_stats.CountsAbove(thresholds);
 
-    if (waittime > config.wait_time_minutes_that_is_too_long_+20)
-      toolongcountplus20 += waitcount;
-  }
+  int toolongcount = static_cast<int>(too_long_counts.at(0));
 
 /*******************************************************************************
- * Print out data about this precint in formatted manner
+ * Print out data about this precint in formatted manner, and keep the numbers
+ * for the results store if there is one
 **/
 
-  ComputeMeanAndDev();
-  outstring = "" + kTag;
-  outstring.append(Utils::Format(iteration, 3) + " ");
-  outstring.append(Utils::Format(pct_number_, 4) + " ");
-  outstring.append(Utils::Format(pct_name_, 25, "left"));
-  outstring.append(Utils::Format(pct_expected_voters_, 6));
-  outstring.append(Utils::Format(station_count, 4));
-  outstring.append(" stations, mean/dev wait (mins) ");
-  outstring.append(Utils::Format(wait_mean_seconds_ / 60.0, 8, 2) + " ");
-  outstring.append(Utils::Format(wait_dev_seconds_ / 60.0, 8, 2) + " toolong ");
-  outstring.append(Utils::Format(toolongcount, 6) + " ");
-  outstring.append(Utils::Format(100.0*toolongcount
-                    / static_cast<double>(pct_expected_voters_), 6, 2));
-  outstring.append(Utils::Format(toolongcountplus10, 6) + " ");
-  outstring.append(Utils::Format(100.0*toolongcountplus10
-                    / static_cast<double>(pct_expected_voters_), 6, 2));
-  outstring.append(Utils::Format(toolongcountplus20, 6) + " ");
-  outstring.append(Utils::Format(100.0*toolongcountplus20
-                    / static_cast<double>(pct_expected_voters_), 6, 2));
-  outstring.append("\n");
+  ResultRow row;
+  row.pct_number = pct_number_;
+  row.station_count = station_count;
+  row.expected_voters = pct_expected_voters_;
+  row.iteration = iteration;
+  row.mean_seconds = wait_mean_seconds_;
+  row.dev_seconds = wait_dev_seconds_;
+  for (int which = 0; which < 3; ++which) {
+    row.too_long[which] = too_long_counts.at(which);
+  }
+
+  bool keep_results = (config.results_filename_ != "");
+  if (!keep_results && !report.Wants(kVerbosePerIteration))
+    return toolongcount;
+
+  row.quantiles[0] = wait_sketch.Quantile(0.50);
+  row.quantiles[1] = wait_sketch.Quantile(0.90);
+  row.quantiles[2] = wait_sketch.Quantile(0.95);
+  row.quantiles[3] = wait_sketch.Quantile(0.99);
 
-  Utils::Output(outstring, out_stream, Utils::log_stream);
+  if (keep_results)
+    results_.push_back(row);
 
-  wait_time_minutes_map.clear();
+  report.Emit(kVerbosePerIteration, [&](Formatter& line) {
+    ResultStore::AppendLine(line, kTag, row, pct_name_);
+  });
 
   return toolongcount;
 
-}  //End OnePct::DoStatistics{...}
+}  //End OnePct::ReportStatistics{...}
 
 /*******************************************************************************
  * Function: 'ReadData'
@@ -289,6 +530,85 @@ void OnePct::ReadData(Scanner& infile) {
   }
 }  // void OnePct::ReadData(Scanner& infile)
 
+/*******************************************************************************
+ * Function: 'ReadRow'
+ * Intializes the precinct from one row of a table that has already been
+ * parsed, in parallel, by PctTable::ReadFile.
+**/
+
+void OnePct::ReadRow(const PctTable& table, int row) {
+  pct_number_ = table.number_.at(row);
+  pct_name_ = table.name_.at(row);
+  pct_turnout_ = table.turnout_.at(row);
+  pct_num_voters_ = table.num_voters_.at(row);
+  pct_expected_voters_ = table.expected_voters_.at(row);
+  pct_expected_per_hour_ = table.expected_per_hour_.at(row);
+  pct_stations_ = table.stations_.at(row);
+  pct_minority_ = table.minority_.at(row);
+
+  stations_to_histo_.clear();
+  for (int sub = 0; sub < kPctTableHistoCount; ++sub) {
+    stations_to_histo_.insert(
+      table.histo_stations_.at(row * kPctTableHistoCount + sub));
+  }
+}  // void OnePct::ReadRow(const PctTable& table, int row)
+
+/*******************************************************************************
+ * Function: 'ReadRecord'
+ * Intializes the precinct from a binary record instead of a line of text.
+**/
+
+void OnePct::ReadRecord(const PctRecord& record) {
+  pct_number_ = record.number;
+  pct_name_ = string(record.name, strnlen(record.name, kPctRecordNameBytes));
+  pct_turnout_ = record.turnout;
+  pct_num_voters_ = record.num_voters;
+  pct_expected_voters_ = record.expected_voters;
+  pct_expected_per_hour_ = record.expected_per_hour;
+  pct_stations_ = record.stations;
+  pct_minority_ = record.minority;
+
+  stations_to_histo_.clear();
+  for (int sub = 0; sub < record.histo_count; ++sub) {
+    stations_to_histo_.insert(record.histo_stations[sub]);
+  }
+}  // void OnePct::ReadRecord(const PctRecord& record)
+
+/*******************************************************************************
+ * Function: 'ToRecord'
+ * Returns the precinct's input data as a binary record. A name too long for
+ * the record is an error, reported the same way as a bad number in a file.
+**/
+
+PctRecord OnePct::ToRecord() const {
+  PctRecord record;
+  memset(&record, 0, sizeof(record));
+
+  if (pct_name_.length() > static_cast<UINT>(kPctRecordNameBytes)) {
+    Utils::log_stream << kTag << "ERROR: precinct name '" << pct_name_
+                      << "' is longer than " << kPctRecordNameBytes << "\n";
+    Utils::log_stream.flush();
+    exit(0);
+  }
+
+  record.number = pct_number_;
+  record.num_voters = pct_num_voters_;
+  record.expected_voters = pct_expected_voters_;
+  record.expected_per_hour = pct_expected_per_hour_;
+  record.stations = pct_stations_;
+  record.turnout = pct_turnout_;
+  record.minority = pct_minority_;
+  memcpy(record.name, pct_name_.data(), pct_name_.length());
+
+  for (auto iter = stations_to_histo_.begin();
+       iter != stations_to_histo_.end(); ++iter) {
+    record.histo_stations[record.histo_count] = *iter;
+    ++record.histo_count;
+  }
+
+  return record;
+}  // PctRecord OnePct::ToRecord() const
+
 /*******************************************************************************
  * Commented by Bryce Blanton
  * November 29 2016
@@ -302,16 +622,22 @@ void OnePct::ReadData(Scanner& infile) {
  *
  * Wait times are calculated for each number of stations by RunSimulationPct2.
  *
- * The results of each simulation are sent to out_stream.
+ * The results of each simulation are sent to 'report', and only there. The
+ * caller copies them to the output file and the log, so a precinct's text can
+ * be collected whole when several precincts are simulated at once. Each line
+ * goes in at its kVerbose level, and is not even formatted unless the output
+ * file or the log wants that level.
  *
  * If histograms are specified in onepct.stations_to_histo_, then a histogram
- * of that station is generated and sent to out_stream.
+ * of that station is generated and sent to 'report'.
  *
 **/
 
 void OnePct::RunSimulationPct(const Configuration& config,
-                              MyRandom& random, ofstream& out_stream) {
-  string outstring = "XX";
+                              MyRandom& random, ReportSink& report) {
+  bool tracing = (config.trace_filename_ != "");
+  results_.clear();
+  trace_.Clear();
 
   // The minimum number of stations = the total time taken / time available
   int min_station_count = pct_expected_voters_
@@ -337,26 +663,65 @@ void OnePct::RunSimulationPct(const Configuration& config,
     if (done_with_this_count)
       break;
     done_with_this_count = true;
+    ScopedTimer stations_timer("stations", stations_count);
+    RunMetrics::SetStationDepth(stations_count - min_station_count + 1);
 
-    map<int, int> map_for_histo;
+    Accumulator histo_stats(kHistoMinutes, 60);
+    QuantileSketch histo_sketch;
 
-    outstring = kTag + this->ToString() + "\n";
-    Utils::Output(outstring, out_stream, Utils::log_stream);
+    report.Emit(kVerbosePerCount, [&](Formatter& line) {
+      line.Append(kTag);
+      this->AppendTo(line);
+      line.Append("\n");
+    });
 
     // For n times, run the simulation and check for a perfect outcome:
     // no one waits longer than specified. Print the results of simulation
     for (int iteration = 0; iteration < config.number_of_iterations_;
          ++iteration) {
-      this->CreateVoters(config, random, out_stream);
+      ScopedTimer iteration_timer("iteration", iteration);
+      if (tracing)
+        trace_.BeginIteration(pct_number_, stations_count, iteration);
+
+      if (config.streaming_voters_) {
+        Accumulator wait_stats(kHistoMinutes, 60);
+        QuantileSketch wait_sketch;
+        this->RunSimulationPctStreaming(config, random, stations_count,
+                                        wait_stats, wait_sketch);
+        if (tracing)
+          trace_.EndIteration();
+        RunMetrics::CountIteration(wait_stats.GetCount());
+        int number_too_long = ReportStatistics(iteration, config,
+                                               stations_count, wait_stats,
+                                               wait_sketch, histo_stats,
+                                               histo_sketch, report);
+        if (number_too_long > 0)
+          done_with_this_count = false;
+        continue;
+      }
+
+      this->CreateVoters(config, random);
+      ScopedTimer::CountItems(voters_backup_.size());
+      RunMetrics::CountIteration(voters_backup_.size());
 
       voters_pending_ = voters_backup_;
       voters_voting_.clear();
       voters_done_voting_.clear();
 
-      this->RunSimulationPct2(stations_count);
+      if ((config.thread_count_ > 1) &&
+          (pct_expected_voters_ >= config.time_parallel_min_voters_))
+        this->RunSimulationPctWindows(config, stations_count);
+      else
+        this->RunSimulationPctEvents(stations_count);
+
+      if (tracing) {
+        this->TraceVoters();
+        trace_.EndIteration();
+      }
 
       int number_too_long = DoStatistics(iteration, config, stations_count,
-                                         map_for_histo, out_stream);
+                                         histo_stats, histo_sketch,
+                                         report);
       if (number_too_long > 0)
         done_with_this_count = false;
     }  // for (int iteration = 0; iteration < config.number_of_iterations_;
@@ -364,53 +729,103 @@ void OnePct::RunSimulationPct(const Configuration& config,
     voters_voting_.clear();
     voters_done_voting_.clear();
 
-    // Print simulation result to out_stream and log_stream
-    outstring = kTag + "toolong space filler\n";
-    Utils::Output(outstring, out_stream, Utils::log_stream);
+    // Print the wait quantiles over all iterations of this station count
+    report.Emit(kVerboseSummary, [&](Formatter& line) {
+      line.Append(kTag);
+      line.Append("toolong ");
+      line.AppendInt(pct_number_, 4);
+      line.Append(" ");
+      line.AppendInt(stations_count, 4);
+      line.Append(" stations, all iterations p50/90/95/99 ");
+      AppendQuantiles(line, histo_sketch);
+      line.Append("\n");
+    });
+
+    // The last station count simulated is the one this precinct ends with
+    final_wait_sketch_ = histo_sketch;
 
     // If any histograms are desired as specified in stations_to_histo_,
-    // generate and send to out_stream
-    if (stations_to_histo_.count(stations_count) > 0) {
-      outstring = "\n" + kTag + "HISTO " + this->ToString() + "\n";
-      outstring.append(kTag + "HISTO STATIONS ");
-      outstring.append(Utils::Format(stations_count, 4) + "\n");
-      Utils::Output(outstring, out_stream, Utils::log_stream);
-
-      int time_lower = (map_for_histo.begin())->first;
-      int time_upper = (map_for_histo.rbegin())->first;
+    // generate and send to 'report'
+    if ((stations_to_histo_.count(stations_count) > 0) &&
+        report.Wants(kVerbosePerCount)) {
+      report.Emit(kVerbosePerCount, [&](Formatter& line) {
+        line.Append("\n" + kTag + "HISTO ");
+        this->AppendTo(line);
+        line.Append("\n" + kTag + "HISTO STATIONS ");
+        line.AppendInt(stations_count, 4);
+        line.Append("\n");
+      });
+
+      // Waits past kHistoMinutes are kept exactly, so they print at their
+      // own minute like the rest
+      int time_lower = histo_stats.GetLowestBin();
+      int time_upper = histo_stats.GetHighestBin();
 
       int voters_per_star = 1;
 
-      if (map_for_histo[time_lower] > 50) {
-        voters_per_star = map_for_histo[time_lower]
+      if (histo_stats.GetBin(time_lower) > 50) {
+        voters_per_star = histo_stats.GetBin(time_lower)
                           / (50 * config.number_of_iterations_);
         if (voters_per_star <= 0)
           voters_per_star = 1;
       }
 
       for (int time = time_lower; time <= time_upper; ++time) {
-        int count = map_for_histo[time];
+        LONG count = histo_stats.GetBin(time);
 
         double count_double = static_cast<double>(count)
                             / static_cast<double>(config.number_of_iterations_);
 
         int count_divided_ceiling = static_cast<int>(ceil(count_double
                                                           / voters_per_star));
-        string stars = string(count_divided_ceiling, '*');
-
-        outstring = kTag + "HISTO " + Utils::Format(time, 6) + ": ";
-        outstring.append(Utils::Format(count_double, 7, 2) + ": ");
-        outstring.append(stars + "\n");
-        Utils::Output(outstring, out_stream, Utils::log_stream);
+        report.Emit(kVerbosePerCount, [&](Formatter& line) {
+          line.Append(kTag);
+          line.Append("HISTO ");
+          line.AppendInt(time, 6);
+          line.Append(": ");
+          line.AppendFixed(count_double, 7, 2);
+          line.Append(": ");
+          line.Append(string(count_divided_ceiling, '*'));
+          line.Append("\n");
+        });
       }  // for (int time = time_lower ; time <= time_upper; ++time) {
 
-      outstring = "HISTO\n\n";
-      Utils::Output(outstring, out_stream, Utils::log_stream);
+      report.Emit(kVerbosePerCount, [&](Formatter& line) {
+        line.Append("HISTO\n\n");
+      });
     }  // if (stations_to_histo_.count (stations_count) > 0) {
   }  // for (int stations_count = min_station_count; ...
 
+  RunMetrics::SetStationDepth(0);
 }
 
+/*******************************************************************************
+ * Function: 'TraceVoters'
+ * Adds every voter of the iteration just simulated to the trace, in sequence
+ * order, which keeps the differences between neighbours small.
+**/
+
+void OnePct::TraceVoters() {
+  ScopedTimer timer("trace");
+  vector<const OneVoter*> voters;
+  voters.reserve(voters_done_voting_.size());
+  for (auto iter = voters_done_voting_.begin();
+       iter != voters_done_voting_.end(); ++iter) {
+    voters.push_back(&iter->second);
+  }
+  sort(voters.begin(), voters.end(),
+       [](const OneVoter* a, const OneVoter* b) {
+         return a->GetSequence() < b->GetSequence();
+       });
+
+  for (UINT sub = 0; sub < voters.size(); ++sub) {
+    const OneVoter* voter = voters.at(sub);
+    trace_.AddVoter(voter->GetSequence(), voter->GetTimeArrival(),
+                    voter->GetTimeStartVoting(), voter->GetTimeVoteDuration(),
+                    voter->GetStationNumber());
+  }
+}  // void OnePct::TraceVoters()
+
 /*******************************************************************************
  * Commented by Bryce Blanton
  * November 29 2016
@@ -427,6 +842,7 @@ void OnePct::RunSimulationPct(const Configuration& config,
  *
 **/
 void OnePct::RunSimulationPct2(int stations_count) {
+  ScopedTimer timer("RunSimulationPct2");
   free_stations_.clear();
 
   // Start wait time simulations with all stations available
@@ -520,6 +936,339 @@ void OnePct::RunSimulationPct2(int stations_count) {
 
 }  // void Simulation::RunSimulationPct2()
 
+/*******************************************************************************
+ * Function 'RunSimulationPctEvents'
+ * Event-driven version of RunSimulationPct2: one RunWindow over the whole
+ * day, stepping from one assignment to the next instead of one second at a
+ * time. The voters, stations and wait times are exactly those of
+ * RunSimulationPct2.
+**/
+void OnePct::RunSimulationPctEvents(int stations_count) {
+  ScopedTimer timer("RunSimulationPctEvents");
+  vector<OneVoter> voters;
+  voters.reserve(voters_pending_.size());
+  for (auto iter = voters_pending_.begin(); iter != voters_pending_.end();
+       ++iter) {
+    voters.push_back(iter->second);
+  }
+
+  PctWindowState state;
+  for (int i = 0; i < stations_count; ++i) {
+    state.free_stations.push_back(i);
+  }
+  vector<pair<int, int> > assigned;
+  RunWindow(voters, 0, 0, true, state, assigned);
+
+  for (UINT sub = 0; sub < assigned.size(); ++sub) {
+    voters.at(sub).AssignStation(assigned.at(sub).second,
+                                 assigned.at(sub).first);
+  }
+  this->SetDoneVoters(voters);
+}  // void OnePct::RunSimulationPctEvents()
+
+/*******************************************************************************
+ * Function 'RunSimulationPctWindows'
+ * Time-parallel version of RunSimulationPct2 for very large precincts.
+ *
+ * The day is cut into the hourly windows of 'arrival_fractions_' (the voters
+ * at time zero belong to the first window, and the last window runs until
+ * everyone has voted). Every window except the first starts from a guess
+ * made by EstimateWindowStarts, and all windows are simulated at once on
+ * 'config.thread_count_' threads.
+ *
+ * Then the fix-up pass walks the windows in order and compares the state
+ * each window actually ended with to the state the next window started
+ * from. If they are the same up to the names of the stations, the next
+ * window's result is already right and its stations are just renamed.
+ * Otherwise the window is given the real state and marked to be re-run.
+ * The stale windows are re-run in parallel and the pass repeats until
+ * nothing changes. The guesses are normally exact, so one parallel run and
+ * one pass are all it takes; whatever the guesses, the first stale window
+ * always has an exact start, so this ends after at most one pass per
+ * window. The voters, stations and wait times are exactly those of
+ * RunSimulationPct2.
+**/
+void OnePct::RunSimulationPctWindows(const Configuration& config,
+                                     int stations_count) {
+  ScopedTimer timer("RunSimulationPctWindows");
+  vector<OneVoter> voters;
+  voters.reserve(voters_pending_.size());
+  for (auto iter = voters_pending_.begin(); iter != voters_pending_.end();
+       ++iter) {
+    voters.push_back(iter->second);
+  }
+
+  int window_count = config.election_day_length_hours_;
+  if (window_count <= 0)
+    window_count = 1;
+
+  vector<PctWindowState> start_states;
+  EstimateWindowStarts(voters, stations_count, window_count, start_states);
+  vector<PctWindowState> end_states(window_count);
+  vector<vector<pair<int, int> > > assigned(window_count);
+  // What each window's stations are renamed to once it is found right
+  vector<vector<int> > relabels(window_count);
+  vector<int> stale_windows;
+  for (int window = 0; window < window_count; ++window) {
+    stale_windows.push_back(window);
+  }
+
+  while (!stale_windows.empty()) {
+    // Run the stale windows, each thread taking the next one in turn
+    Utils::ParallelFor(static_cast<int>(stale_windows.size()),
+                       config.thread_count_, [&](int sub) {
+      int window = stale_windows.at(sub);
+      bool is_last = (window == window_count - 1);
+      end_states.at(window) = start_states.at(window);
+      RunWindow(voters, window * 3600, (window + 1) * 3600, is_last,
+                end_states.at(window), assigned.at(window));
+      relabels.at(window).clear();
+      for (int station = 0; station < stations_count; ++station) {
+        relabels.at(window).push_back(station);
+      }
+    });
+
+    // Fix-up pass: carry each window's end state into the next window
+    stale_windows.clear();
+    for (int window = 1; window < window_count; ++window) {
+      const PctWindowState& actual = end_states.at(window - 1);
+      vector<int> relabel;
+
+      if (WindowStatesMatch(actual, start_states.at(window), relabel)) {
+        for (auto iter = relabels.at(window).begin();
+             iter != relabels.at(window).end(); ++iter) {
+          *iter = relabel.at(*iter);
+        }
+        PctWindowState& end_state = end_states.at(window);
+        for (auto iter = end_state.busy.begin(); iter != end_state.busy.end();
+             ++iter) {
+          iter->second.second = relabel.at(iter->second.second);
+        }
+        for (auto iter = end_state.free_stations.begin();
+             iter != end_state.free_stations.end(); ++iter) {
+          *iter = relabel.at(*iter);
+        }
+      } else {
+        stale_windows.push_back(window);
+      }
+      start_states.at(window) = actual;
+    }
+  }  // while (!stale_windows.empty()) {
+
+  // Every voter now has its exact start and station. The windows' voters
+  // are apart, so they are given their stations in parallel too.
+  Utils::ParallelFor(window_count, config.thread_count_, [&](int window) {
+    int sub = start_states.at(window).next_voter;
+    for (auto iter = assigned.at(window).begin();
+         iter != assigned.at(window).end(); ++iter) {
+      voters.at(sub).AssignStation(relabels.at(window).at(iter->second),
+                                   iter->first);
+      ++sub;
+    }
+  });
+
+  this->SetDoneVoters(voters);
+}  // void OnePct::RunSimulationPctWindows()
+
+/*******************************************************************************
+ * Function 'SetDoneVoters'
+ * Makes 'voters', in arrival order and with their stations, the voters done
+ * voting. Inserting them in arrival order puts voters leaving at the same
+ * second in the order they were assigned, just as RunSimulationPct2 does.
+**/
+void OnePct::SetDoneVoters(const vector<OneVoter>& voters) {
+  voters_voting_.clear();
+  voters_done_voting_.clear();
+  for (auto iter = voters.begin(); iter != voters.end(); ++iter) {
+    voters_done_voting_.insert(std::pair<int, OneVoter>
+                               (iter->GetTimeDoneVoting(), *iter));
+  }
+  voters_pending_.clear();
+}  // void OnePct::SetDoneVoters()
+
+/*******************************************************************************
+ * Function 'EstimateWindowStarts'
+ * Guesses the state each window of RunSimulationPctWindows starts from, with
+ * one quick serial pass over the day. It keeps only a heap of the times the
+ * stations come free and follows the rule of RunWindow: each voter starts at
+ * the latest of its arrival, the previous start, and the earliest free time.
+ * The voters still voting when a window begins, in order of leaving and then
+ * of assignment (which is arrival order), are that window's busy voters and
+ * the other stations are free. The station numbers are made up, which
+ * WindowStatesMatch allows for.
+ *
+ * With no free list to keep in order and no stations to hand out, this costs
+ * a small part of the windows themselves, and its guesses are exact, so the
+ * fix-up pass only checks them.
+**/
+void OnePct::EstimateWindowStarts(const vector<OneVoter>& voters,
+                                  int stations_count, int window_count,
+                                  vector<PctWindowState>& start_states) {
+  ScopedTimer timer("EstimateWindowStarts");
+  start_states.assign(window_count, PctWindowState());
+
+  // (free time, voter subscript or -1) of each station, earliest on top
+  vector<pair<int, int> > free_times(stations_count, make_pair(0, -1));
+  greater<pair<int, int> > later;
+  int voter_count = static_cast<int>(voters.size());
+  int window = 0;
+
+  // Record the start of 'window' with 'next_voter' the next to be assigned
+  auto record_window = [&](int next_voter) {
+    PctWindowState& state = start_states.at(window);
+    state.next_voter = next_voter;
+    vector<pair<int, int> > leaving;
+    for (auto iter = free_times.begin(); iter != free_times.end(); ++iter) {
+      if ((iter->second >= 0) && (iter->first >= window * 3600))
+        leaving.push_back(*iter);
+    }
+    sort(leaving.begin(), leaving.end());
+
+    int station = 0;
+    for (auto iter = leaving.begin(); iter != leaving.end(); ++iter) {
+      state.busy.insert(std::pair<int, pair<int, int> >
+                        (iter->first, make_pair(iter->second, station)));
+      ++station;
+    }
+    for (; station < stations_count; ++station) {
+      state.free_stations.push_back(station);
+    }
+    ++window;
+  };
+
+  int previous_start = 0;
+  for (int sub = 0; sub < voter_count; ++sub) {
+    const OneVoter& voter = voters.at(sub);
+    int start = max(max(voter.GetTimeArrival(), previous_start),
+                    free_times.front().first);
+    while ((window < window_count) && (start >= window * 3600)) {
+      record_window(sub);
+    }
+
+    pop_heap(free_times.begin(), free_times.end(), later);
+    free_times.back() = make_pair(start + voter.GetTimeVoteDuration(), sub);
+    push_heap(free_times.begin(), free_times.end(), later);
+    previous_start = start;
+  }
+  while (window < window_count) {
+    record_window(voter_count);
+  }
+}  // void OnePct::EstimateWindowStarts()
+
+/*******************************************************************************
+ * Function 'RunWindow'
+ * Simulates the voters of one window, from 'window_begin' up to but not
+ * including 'window_end' (or until everyone has voted if 'is_last').
+ *
+ * This steps from one assignment to the next instead of one second at a time
+ * but follows the same rules as RunSimulationPct2: voters are taken in
+ * arrival order, at each second the stations of departing voters go on the
+ * end of the free list first (in the order those voters were assigned), and
+ * then waiting voters take stations from the front of the free list.
+**/
+void OnePct::RunWindow(const vector<OneVoter>& voters, int window_begin,
+                       int window_end, bool is_last, PctWindowState& state,
+                       vector<pair<int, int> >& assigned) {
+  assigned.clear();
+  int voter_count = static_cast<int>(voters.size());
+  int now = window_begin;
+
+  // Put the stations of voters leaving at or before 'second' back in the
+  // free list
+  auto release_stations = [&state](int second) {
+    while (!state.busy.empty() && state.busy.begin()->first <= second) {
+      state.free_stations.push_back(state.busy.begin()->second.second);
+      state.busy.erase(state.busy.begin());
+    }
+  };
+
+  while (state.next_voter < voter_count) {
+    const OneVoter& next_voter = voters.at(state.next_voter);
+    int second = max(now, next_voter.GetTimeArrival());
+    if (!is_last && second >= window_end)
+      break;
+
+    release_stations(second);
+    if (state.free_stations.empty()) {
+      // Wait for the next departure
+      second = state.busy.begin()->first;
+      if (!is_last && second >= window_end)
+        break;
+      release_stations(second);
+    }
+
+    int which_station = state.free_stations.at(0);
+    state.free_stations.erase(state.free_stations.begin());
+    int leave_time = second + next_voter.GetTimeVoteDuration();
+    state.busy.insert(std::pair<int, pair<int, int> >
+                      (leave_time, make_pair(state.next_voter, which_station)));
+    assigned.push_back(make_pair(second, which_station));
+
+    now = second;
+    ++state.next_voter;
+  }
+
+  if (!is_last)
+    release_stations(window_end - 1);
+}  // void OnePct::RunWindow()
+
+/*******************************************************************************
+ * Function 'WindowStatesMatch'
+ * The voters a window assigns depend only on who is in line and when the
+ * busy stations come free, not on the numbers of the stations. So a guessed
+ * start state is good enough if it has the same next voter, the same busy
+ * voters leaving at the same times in the same order, and a free list of
+ * the same length. The station renaming that maps the guess onto the actual
+ * state is returned in 'relabel'.
+**/
+bool OnePct::WindowStatesMatch(const PctWindowState& actual,
+                               const PctWindowState& guess,
+                               vector<int>& relabel) {
+  if ((actual.next_voter != guess.next_voter) ||
+      (actual.busy.size() != guess.busy.size()) ||
+      (actual.free_stations.size() != guess.free_stations.size()))
+    return false;
+
+  relabel.assign(actual.busy.size() + actual.free_stations.size(), -1);
+
+  auto iter_guess = guess.busy.begin();
+  for (auto iter = actual.busy.begin(); iter != actual.busy.end();
+       ++iter, ++iter_guess) {
+    if ((iter->first != iter_guess->first) ||
+        (iter->second.first != iter_guess->second.first))
+      return false;
+    relabel.at(iter_guess->second.second) = iter->second.second;
+  }
+
+  for (UINT sub = 0; sub < actual.free_stations.size(); ++sub) {
+    relabel.at(guess.free_stations.at(sub)) = actual.free_stations.at(sub);
+  }
+
+  return true;
+}  // bool OnePct::WindowStatesMatch()
+
+/*******************************************************************************
+ * Function 'FormatQuantiles'
+ * Formats the median, 90th, 95th and 99th percentile waits in minutes.
+**/
+string OnePct::FormatQuantiles(const QuantileSketch& wait_sketch) {
+  Formatter line;
+  AppendQuantiles(line, wait_sketch);
+  return line.GetString();
+}  // string OnePct::FormatQuantiles()
+
+/*******************************************************************************
+ * Function 'AppendQuantiles'
+ * Same as FormatQuantiles, added to the end of a line being built.
+**/
+void OnePct::AppendQuantiles(Formatter& line,
+                             const QuantileSketch& wait_sketch) {
+  line.AppendFixed(wait_sketch.Quantile(0.50) / 60.0, 8, 2);
+  line.AppendFixed(wait_sketch.Quantile(0.90) / 60.0, 8, 2);
+  line.AppendFixed(wait_sketch.Quantile(0.95) / 60.0, 8, 2);
+  line.AppendFixed(wait_sketch.Quantile(0.99) / 60.0, 8, 2);
+}  // void OnePct::AppendQuantiles()
+
 /*******************************************************************************
  *
  * Commented by Bryce Blanton
@@ -533,26 +1282,36 @@ void OnePct::RunSimulationPct2(int stations_count) {
  *
 **/
 string OnePct::ToString() {
-  string s = "";
-
-  s.append(Utils::Format(pct_number_, 4) + " ");
-  s.append(Utils::Format(pct_name_, 25, "left"));
-  s.append(Utils::Format(pct_turnout_, 8, 2));
-  s.append(Utils::Format(pct_num_voters_, 8));
-  s.append(Utils::Format(pct_expected_voters_, 8));
-  s.append(Utils::Format(pct_expected_per_hour_, 8));
-  s.append(Utils::Format(pct_stations_, 3));
-  s.append(Utils::Format(pct_minority_, 8, 2));
-  s.append(" HH ");
+  Formatter line;
+  this->AppendTo(line);
+  return line.GetString();
+}  // string OnePct::ToString()
+
+/*******************************************************************************
+ * Function 'AppendTo'
+ * Builds the ToString text at the end of a line the caller owns.
+ *
+ * The turnout is padded on the right. It was formatted straight after the
+ * left-justified name, and the old shared format stream kept the 'left'.
+**/
+void OnePct::AppendTo(Formatter& line) const {
+  line.AppendInt(pct_number_, 4);
+  line.Append(" ");
+  line.AppendLeft(pct_name_, 25);
+  line.AppendDouble(pct_turnout_, 8, 2, true, true);
+  line.AppendInt(pct_num_voters_, 8);
+  line.AppendInt(pct_expected_voters_, 8);
+  line.AppendInt(pct_expected_per_hour_, 8);
+  line.AppendInt(pct_stations_, 3);
+  line.AppendFixed(pct_minority_, 8, 2);
+  line.Append(" HH ");
 
   for (auto iter = stations_to_histo_.begin(); iter != stations_to_histo_.end();
        ++iter) {
-    s.append(Utils::Format(*iter, 4));
+    line.AppendInt(*iter, 4);
   }
-  s.append(" HH");
-
-  return s;
-}  // string OnePct::ToString()
+  line.Append(" HH");
+}  // void OnePct::AppendTo(Formatter& line) const
 
 /*******************************************************************************
  *
@@ -566,14 +1325,23 @@ string OnePct::ToString() {
  *
 **/
 string OnePct::ToStringVoterMap(string label, multimap<int, OneVoter> themap) {
-  string s =  "\n" + label + " WITH ";
-
-  s.append(Utils::Format(static_cast<int>(themap.size()), 6) + " ENTRIES\n");
-  s.append(OneVoter::ToStringHeader() + "\n");
+  Formatter lines;
+  AppendVoterMap(lines, label, themap);
+  return lines.GetString();
+}  // string OnePct::ToStringVoterMap()
+
+void OnePct::AppendVoterMap(Formatter& lines, const string& label,
+                            const multimap<int, OneVoter>& themap) {
+  lines.Append("\n");
+  lines.Append(label);
+  lines.Append(" WITH ");
+  lines.AppendInt(static_cast<int>(themap.size()), 6);
+  lines.Append(" ENTRIES\n");
+  lines.Append(OneVoter::ToStringHeader());
+  lines.Append("\n");
 
   for (auto iter = themap.begin(); iter != themap.end(); ++iter) {
-    s.append((iter->second).ToString() + "\n");
+    (iter->second).AppendTo(lines);
+    lines.Append("\n");
   }
-
-  return s;
-}  // string OnePct::ToString()
+}  // void OnePct::AppendVoterMap()
@@ -16,11 +16,21 @@
 #ifndef ONEPCT_H
 #define ONEPCT_H
 
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <queue>
 #include <set>
 #include <vector>
 
+#include "../Utilities/accumulator.h"
+#include "../Utilities/formatter.h"
+#include "../Utilities/quantilesketch.h"
+#include "../Utilities/reportsink.h"
+#include "../Utilities/scopedtimer.h"
 #include "../Utilities/utils.h"
 #include "../Utilities/scanner.h"
 #include "../Utilities/scanline.h"
@@ -30,11 +40,57 @@ using namespace std;
 #include "configuration.h"
 #include "myrandom.h"
 #include "onevoter.h"
+#include "pcttable.h"
+#include "resultstore.h"
+#include "runmetrics.h"
+#include "votertrace.h"
 
 static const double kDummyDouble = -88.88;
 static const int kDummyInt = -999;
 static const string kDummyString = "dummystring";
 
+// Wait time histograms have a dense bin per minute up to two days; the rare
+// longer waits get sparse bins of their own
+static const int kHistoMinutes = 2 * 24 * 60;
+
+/*******************************************************************************
+ * One precinct's input data in a fixed binary layout, for the input files
+ * that are mapped into memory instead of parsed. 'histo_stations' holds the
+ * distinct station counts to histogram, 'histo_count' of them.
+**/
+static const int kPctRecordNameBytes = 32;
+static const int kPctRecordMaxHisto = 3;
+
+struct PctRecord {
+  int32_t number;
+  int32_t num_voters;
+  int32_t expected_voters;
+  int32_t expected_per_hour;
+  int32_t stations;
+  int32_t histo_count;
+  int32_t histo_stations[kPctRecordMaxHisto];
+  int32_t unused;
+  double turnout;
+  double minority;
+  char name[kPctRecordNameBytes];
+};
+
+/*******************************************************************************
+ * The state of a precinct's stations at the start of an hourly window, used by
+ * RunWindow and the time-parallel engine. 'next_voter' is the subscript (in
+ * arrival order) of the first voter not yet assigned a station, 'busy' maps
+ * each departure time to the (voter subscript, station) leaving then, in
+ * assignment order, and 'free_stations' is the free list in the order
+ * stations will be handed out. This is exactly what RunSimulationPct2
+ * carries from second to second. The voter subscripts let WindowStatesMatch
+ * tell two states with the same departure times apart.
+**/
+struct PctWindowState {
+  int next_voter = 0;
+  multimap<int, pair<int, int> > busy;
+  vector<int> free_stations;
+};
+
 class OnePct {
 public:
  
@@ -54,6 +110,14 @@ public:
  int GetExpectedVoters() const;
  // Returns pct_number_
  int GetPctNumber() const;
+ // Returns pct_name_
+ const string& GetPctName() const;
+ // Returns the waits for the station count the precinct ended with
+ const QuantileSketch& GetFinalWaitSketch() const;
+ // Returns the numbers of every iteration's report line, if they were kept
+ const vector<ResultRow>& GetResults() const;
+ // Where the voter trace goes, block by block, if voters are traced
+ void SetTraceSink(ostream* sink);
 
 /******************************************************************************
  * General functions.
@@ -61,15 +125,33 @@ public:
  // Reads precinct data from a structured, space delimited file
 
  void ReadData(Scanner& infile);
+ // Sets the precinct data from one row of a parsed precinct table
+ void ReadRow(const PctTable& table, int row);
+ // Sets the precinct data from, or copies it to, a fixed binary record
+ void ReadRecord(const PctRecord& record);
+ PctRecord ToRecord() const;
  // Iteratively simulates the wait time outcomes for a number of stations
- // scenarios in a precinct and sends the results to out_stream
+ // scenarios in a precinct and sends the results to 'report', each line at
+ // its kVerbose level
  void RunSimulationPct(const Configuration& config, MyRandom& random,
-                       ofstream& out_stream);
+                       ReportSink& report);
 
+ // Adds the same text as ToString to the end of 'line'
+ void AppendTo(Formatter& line) const;
  string ToString();
  string ToStringVoterMap(string label, multimap<int, OneVoter> themap);
+ // Adds the same text as ToStringVoterMap to the end of 'lines'
+ static void AppendVoterMap(Formatter& lines, const string& label,
+                            const multimap<int, OneVoter>& themap);
+ // Formats the 50th, 90th, 95th and 99th percentile waits in minutes
+ static string FormatQuantiles(const QuantileSketch& wait_sketch);
+ static void AppendQuantiles(Formatter& line,
+                             const QuantileSketch& wait_sketch);
 
 private:
+ // The microbenchmarks time the private engines directly
+ friend class OnePctBench;
+
  int    pct_expected_voters_ = kDummyInt;
  int    pct_expected_per_hour_ = kDummyInt;
  double pct_minority_ = kDummyDouble;
@@ -86,23 +168,67 @@ private:
  multimap<int, OneVoter> voters_done_voting_;
  multimap<int, OneVoter> voters_pending_;
  multimap<int, OneVoter> voters_voting_;
+ QuantileSketch final_wait_sketch_;
+ // Kept only when the configuration asks for a results store
+ vector<ResultRow> results_;
+ // Kept only when the configuration asks for a voter trace
+ VoterTrace trace_;
 
 /*******************************************************************************
  * General private functions.
 **/
  // Populates voters_backup
 
- void CreateVoters(const Configuration& config, MyRandom& random,
-                   ofstream& out_stream);
+ void CreateVoters(const Configuration& config, MyRandom& random);
+ // Populates voters_backup with each hour generated from its own stream
+ void CreateVotersHourly(const Configuration& config, MyRandom& random);
+ // Returns the number of voters at time zero and in each hour
+ vector<int> HourlyBlockCounts(const Configuration& config) const;
+ // Simulates one iteration generating voters as they are needed and folding
+ // each wait into the statistics, without keeping any voters
+ void RunSimulationPctStreaming(const Configuration& config, MyRandom& random,
+                                int stations_count,
+                                Accumulator& wait_stats,
+                                QuantileSketch& wait_sketch);
  // Calculates, Returns the number of voters who waited longer than desired
  // Additionally, prints out this precincts variables
  int DoStatistics(int iteration, const Configuration& config, 
-                  int station_count, map<int, int>& map_for_histo,
-       	          ofstream& out_stream);
+                  int station_count, Accumulator& histo_stats,
+                  QuantileSketch& histo_sketch, ReportSink& report);
+ // Prints one iteration's results from its wait times, merges them into
+ // histo_stats and histo_sketch, and returns the number who waited too long
+ int ReportStatistics(int iteration, const Configuration& config,
+                      int station_count, const Accumulator& wait_stats,
+                      const QuantileSketch& wait_sketch,
+                      Accumulator& histo_stats, QuantileSketch& histo_sketch,
+                      ReportSink& report);
+ // Adds the voters of the iteration just simulated to trace_
+ void TraceVoters();
  // Computes wait mean and standard deviation
- void ComputeMeanAndDev();
+ void ComputeMeanAndDev(const Accumulator& wait_stats);
  // Calculates the waiting times for each voter
  void RunSimulationPct2(int stations);
+ // Same result as RunSimulationPct2, event by event in one pass
+ void RunSimulationPctEvents(int stations);
+ // Same result as RunSimulationPct2, with the hourly windows of the day
+ // simulated on separate threads and then fixed up until consistent
+ void RunSimulationPctWindows(const Configuration& config, int stations);
+ // Makes 'voters', with their stations, the voters done voting
+ void SetDoneVoters(const vector<OneVoter>& voters);
+ // Guesses the state each hourly window starts from, for the above
+ static void EstimateWindowStarts(const vector<OneVoter>& voters,
+                                  int stations_count, int window_count,
+                                  vector<PctWindowState>& start_states);
+ // Simulates one window of voters starting from 'state', leaving the end
+ // state in 'state' and the (start, station) of each voter in 'assigned'
+ static void RunWindow(const vector<OneVoter>& voters, int window_begin,
+                       int window_end, bool is_last, PctWindowState& state,
+                       vector<pair<int, int> >& assigned);
+ // Returns true if 'guess' is 'actual' up to a renaming of the stations,
+ // and fills 'relabel' with that renaming from guessed to actual stations
+ static bool WindowStatesMatch(const PctWindowState& actual,
+                               const PctWindowState& guess,
+                               vector<int>& relabel);
 
 };
 
@@ -51,6 +51,22 @@ OneVoter::~OneVoter() {
  * Accessors and mutators.
  **/
 
+/******************************************************************************
+ * Returns the sequence number of an individual voter
+ **/
+
+int OneVoter::GetSequence() const {
+  return sequence_;
+}
+
+/******************************************************************************
+ * Returns the time an individual voter started voting
+ **/
+
+int OneVoter::GetTimeStartVoting() const {
+  return time_start_voting_seconds_;
+}
+
 /******************************************************************************
  * Returns the arrival time of an individual voter
  **/
@@ -67,6 +83,14 @@ int OneVoter::GetTimeWaiting() const {
   return time_waiting_seconds_;
 }
 
+/******************************************************************************
+ * Returns the length of time an individual voter takes to vote
+ **/
+
+int OneVoter::GetTimeVoteDuration() const {
+  return time_vote_duration_seconds_;
+}
+
 /******************************************************************************
  * Returns the polling station number of an individual voter
  **/
@@ -133,54 +157,53 @@ string OneVoter::GetTOD(int time_in_seconds) const {
  * ConvertTime takes in an int,  time_in_seconds. This number is then used to
  * create a formatted number output in the form of 'HH:MM:SS'. It does this by
  * dividing time_in_seconds to calculate hours, minutes, and seconds. The
- * corresponding output is then formatted by the included utils package. The
- * resulting formatted string is then returned.
+ * corresponding output is then formatted by AppendTime. The resulting
+ * formatted string is then returned.
  **/
 string OneVoter::ConvertTime(int time_in_seconds) const {
-  int hours = 0;
-  int minutes = 0;
-  int seconds = 0;
-  string s = "";
+  Formatter line;
+  this->AppendTime(line, time_in_seconds);
+  return line.GetString();
+} // string OneVoter::ConvertTime(int time_in_seconds) const
 
-  //int automatically rounds down to the nearest hour
-  hours = time_in_seconds / 3600;
-  //subtracts the number of hours from time then calculates minutes
-  minutes = (time_in_seconds - 3600 * hours) / 60;
-  //subtracts the number of hours and minutes from time then calculates
-  //seconds
-  seconds = (time_in_seconds - 3600 * hours - 60 * minutes);
+/******************************************************************************
+ * AppendTime does the work of ConvertTime, adding the seconds and 'HH:MM:SS'
+ * straight to the end of a line being built.
+ **/
+void OneVoter::AppendTime(Formatter& line, int time_in_seconds) const {
+  int hours = time_in_seconds / 3600;
+  int minutes = (time_in_seconds - 3600 * hours) / 60;
+  int seconds = (time_in_seconds - 3600 * hours - 60 * minutes);
 
-  s.append(Utils::Format(time_in_seconds, 6));
+  line.AppendInt(time_in_seconds, 6);
 
+  line.Append(" ");
   if (hours < 0) {
-    s.append(" 00");
+    line.Append("00");
   } else {
     if (hours < 10)
-      s.append(" 0" + Utils::Format(hours, 1));
-    else
-      s.append(" " + Utils::Format(hours, 2));
+      line.Append("0");
+    line.AppendInt(hours, 0);
   }
 
+  line.Append(":");
   if (minutes < 0) {
-    s.append(":00");
+    line.Append("00");
   } else {
     if (minutes < 10)
-      s.append(":0" + Utils::Format(minutes, 1));
-    else
-      s.append(":" + Utils::Format(minutes, 2));
+      line.Append("0");
+    line.AppendInt(minutes, 0);
   }
 
+  line.Append(":");
   if (seconds < 0) {
-    s.append(":00");
+    line.Append("00");
   } else {
     if (seconds < 10)
-      s.append(":0" + Utils::Format(seconds, 1));
-    else
-      s.append(":" + Utils::Format(seconds, 2));
+      line.Append("0");
+    line.AppendInt(seconds, 0);
   }
-
-  return s;
-} // string OneVoter::ConvertTime(int time_in_seconds) const
+} // void OneVoter::AppendTime(Formatter& line, int time_in_seconds) const
 
 /******************************************************************************
  * OneVoter::ToString outputs the individual characteristics for a voter.  The
@@ -192,19 +215,34 @@ string OneVoter::ConvertTime(int time_in_seconds) const {
  **/
 
 string OneVoter::ToString() {
-  string s = kTag;
+  Formatter line;
+  this->AppendTo(line);
+  return line.GetString();
+} // string OneVoter::toString()
 
-  s.append(Utils::Format(sequence_, 7) + ": ");
-  s.append(Utils::Format(this->GetTOD(time_arrival_seconds_)) + " ");
-  s.append(Utils::Format(this->GetTOD(time_start_voting_seconds_)) +" ");
-  s.append(Utils::Format(this->ConvertTime(time_vote_duration_seconds_)) +" ");
-  s.append(Utils::Format(this->GetTOD(time_start_voting_seconds_
-                                      + time_vote_duration_seconds_)) + " ");
-  s.append(Utils::Format(this->ConvertTime(GetTimeInQ())) + ": ");
-  s.append(Utils::Format(which_station_, 4));
+/******************************************************************************
+ * AppendTo builds the ToString text at the end of a line the caller owns, so
+ * a dump of many voters can reuse one buffer. The times of day are GetTOD's,
+ * which has no offset, so they are written directly.
+ **/
 
-  return s;
-} // string OneVoter::toString()
+void OneVoter::AppendTo(Formatter& line) const {
+  line.Append(kTag);
+  line.AppendInt(sequence_, 7);
+  line.Append(": ");
+  this->AppendTime(line, time_arrival_seconds_);
+  line.Append(" ");
+  this->AppendTime(line, time_start_voting_seconds_);
+  line.Append(" ");
+  this->AppendTime(line, time_vote_duration_seconds_);
+  line.Append(" ");
+  this->AppendTime(line, time_start_voting_seconds_
+                         + time_vote_duration_seconds_);
+  line.Append(" ");
+  this->AppendTime(line, this->GetTimeInQ());
+  line.Append(": ");
+  line.AppendInt(which_station_, 4);
+} // void OneVoter::AppendTo(Formatter& line) const
 
 /******************************************************************************
  *ToStringHeader is the header that goes above the output, OneVoter::ToString, 
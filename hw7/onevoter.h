@@ -18,6 +18,7 @@
 #ifndef ONEVOTER_H
 #define ONEVOTER_H
 
+#include "../Utilities/formatter.h"
 #include "../Utilities/utils.h"
 
 using namespace std;
@@ -39,9 +40,12 @@ public:
  * Accessors and Mutators.
 **/
  
+ int GetSequence() const;
  int GetStationNumber() const;
  int GetTimeArrival() const;
+ int GetTimeStartVoting() const;
  int GetTimeDoneVoting() const;
+ int GetTimeVoteDuration() const;
  int GetTimeWaiting() const;
 
 /*******************************************************************************
@@ -52,6 +56,8 @@ public:
  void DoneVoting();
  int GetTimeInQ() const;
 
+ // Adds the same text as ToString to the end of 'line'
+ void AppendTo(Formatter& line) const;
  string ToString();
  static string ToStringHeader();
 
@@ -68,6 +74,7 @@ private:
  * General private functions.
 **/
  
+ void AppendTime(Formatter& line, int time_in_seconds) const;
  string ConvertTime(int time_in_seconds) const;
  string GetTOD(int time) const;
 };
@@ -0,0 +1,126 @@
+#include "pcttable.h"
+/*******************************************************************************
+ * Implementation for the 'PctTable' class.
+**/
+
+static const string kTag = "PCTTABLE: ";
+
+// Files smaller than this per thread are not worth splitting
+static const size_t kMinChunkBytes = 64 * 1024;
+
+/*******************************************************************************
+ * Constructor.
+**/
+PctTable::PctTable() {
+}
+
+/*******************************************************************************
+ * Destructor.
+**/
+PctTable::~PctTable() {
+}
+
+/*******************************************************************************
+ * Accessors and mutators.
+**/
+int PctTable::GetRowCount() const {
+  return static_cast<int>(number_.size());
+}
+
+/*******************************************************************************
+ * General functions.
+**/
+
+/*******************************************************************************
+ * Function 'Append'.
+**/
+void PctTable::Append(const PctTable& other) {
+  number_.insert(number_.end(), other.number_.begin(), other.number_.end());
+  name_.insert(name_.end(), other.name_.begin(), other.name_.end());
+  turnout_.insert(turnout_.end(), other.turnout_.begin(),
+                  other.turnout_.end());
+  num_voters_.insert(num_voters_.end(), other.num_voters_.begin(),
+                     other.num_voters_.end());
+  expected_voters_.insert(expected_voters_.end(),
+                          other.expected_voters_.begin(),
+                          other.expected_voters_.end());
+  expected_per_hour_.insert(expected_per_hour_.end(),
+                            other.expected_per_hour_.begin(),
+                            other.expected_per_hour_.end());
+  stations_.insert(stations_.end(), other.stations_.begin(),
+                   other.stations_.end());
+  minority_.insert(minority_.end(), other.minority_.begin(),
+                   other.minority_.end());
+  histo_stations_.insert(histo_stations_.end(),
+                         other.histo_stations_.begin(),
+                         other.histo_stations_.end());
+}
+
+/*******************************************************************************
+ * Function 'ReadFile'.
+ * Maps the file and cuts it into one chunk per thread. Every cut after the
+ * first is moved forward to just past a newline, so no row is split. Each
+ * chunk is parsed into its own table and the tables are appended in order.
+**/
+bool PctTable::ReadFile(const string& filename, int thread_count) {
+  MappedFile file;
+  if (!file.Open(filename))
+    return false;
+
+  const char* data = file.GetData();
+  size_t size = file.GetSize();
+
+  size_t chunk_count = static_cast<size_t>(thread_count);
+  if (chunk_count > size / kMinChunkBytes)
+    chunk_count = size / kMinChunkBytes;
+  if (chunk_count < 1)
+    chunk_count = 1;
+
+  vector<size_t> cuts(chunk_count + 1, size);
+  cuts[0] = 0;
+  for (size_t chunk = 1; chunk < chunk_count; ++chunk) {
+    size_t cut = chunk * (size / chunk_count);
+    if (cut < cuts[chunk - 1])
+      cut = cuts[chunk - 1];
+    while ((cut < size) && (data[cut - 1] != '\n'))
+      ++cut;
+    cuts[chunk] = cut;
+  }
+
+  vector<PctTable> chunk_tables(chunk_count);
+  Utils::ParallelFor(static_cast<int>(chunk_count), thread_count,
+                     [&](int chunk) {
+    chunk_tables[chunk].ParseRows(data + cuts[chunk], data + cuts[chunk + 1]);
+  });
+
+  for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+    this->Append(chunk_tables[chunk]);
+  }
+
+  cout << kTag << "parsed " << this->GetRowCount() << " precincts from '"
+       << filename << "' in " << chunk_count << " chunks\n";
+  return true;
+}
+
+/*******************************************************************************
+ * Function 'ParseRows'.
+ * Parses every row in [begin, end), the same fields in the same order as
+ * OnePct::ReadData.
+**/
+void PctTable::ParseRows(const char* begin, const char* end) {
+  Tokenizer tokens;
+  tokens.Reset(begin, end);
+  while (tokens.HasNext()) {
+    number_.push_back(tokens.NextInt());
+    name_.push_back(tokens.Next());
+    turnout_.push_back(tokens.NextDouble());
+    num_voters_.push_back(tokens.NextInt());
+    expected_voters_.push_back(tokens.NextInt());
+    expected_per_hour_.push_back(tokens.NextInt());
+    stations_.push_back(tokens.NextInt());
+    minority_.push_back(tokens.NextDouble());
+    for (int sub = 0; sub < kPctTableHistoCount; ++sub) {
+      histo_stations_.push_back(tokens.NextInt());
+    }
+  }
+}
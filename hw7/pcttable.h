@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Header for the 'PctTable' class.
+ *
+ * A PctTable holds the rows of a precinct file one column per field, in the
+ * order the rows appear in the file. A row is one line:
+ *   number name turnout voters expected per-hour stations minority h1 h2 h3
+ *
+ * 'ReadFile' maps the file and splits it into newline-aligned chunks. Each
+ * chunk is parsed on its own thread into its own table, and the chunk tables
+ * are appended in file order, so the result is the same for any number of
+ * threads.
+**/
+
+#ifndef PCTTABLE_H
+#define PCTTABLE_H
+
+#include <string>
+#include <vector>
+
+#include "../Utilities/mappedfile.h"
+#include "../Utilities/tokenizer.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+static const int kPctTableHistoCount = 3;
+
+class PctTable {
+public:
+/*******************************************************************************
+ * Constructors and destructors for the class.
+**/
+ PctTable();
+ virtual ~PctTable();
+
+/*******************************************************************************
+ * Accessors and Mutators.
+**/
+ int GetRowCount() const;
+
+/*******************************************************************************
+ * Columns, one entry per row. 'histo_stations_' has kPctTableHistoCount
+ * entries per row.
+**/
+ vector<int> number_;
+ vector<string> name_;
+ vector<double> turnout_;
+ vector<int> num_voters_;
+ vector<int> expected_voters_;
+ vector<int> expected_per_hour_;
+ vector<int> stations_;
+ vector<double> minority_;
+ vector<int> histo_stations_;
+
+/*******************************************************************************
+ * General functions.
+**/
+ // Adds the rows of another table after these
+ void Append(const PctTable& other);
+ // Parses a precinct file on up to thread_count threads; false if the file
+ // cannot be mapped, so the caller can read it with a Scanner instead
+ bool ReadFile(const string& filename, int thread_count);
+
+private:
+ void ParseRows(const char* begin, const char* end);
+};
+
+#endif // PCTTABLE_H
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Main program for reading a results store or a voter trace.
+ *
+ * Prints the per-iteration lines of the report from a results store that
+ * Aprog wrote with '--results=FILE', the same text Aprog printed, for every
+ * precinct, one precinct, or one precinct at one station count:
+ *
+ *   Rprog resultsfile [pctnumber [stations]]
+ *
+ * Only the header and trailer, the index entries the binary search probes,
+ * the entries asked for (each checked against the one before it) and their
+ * rows are read from the mapped file.
+ *
+ * Given a voter trace that Aprog wrote with '--trace=FILE' instead, it prints
+ * the voters of the iterations asked for the same way.
+**/
+
+#include <climits>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+#include "resultstore.h"
+#include "votertrace.h"
+
+// The tag on the lines as Aprog wrote them
+static const string kReportTag = "OnePct: ";
+
+int main(int argc, char *argv[]) {
+  Utils::CheckArgsAtLeast(1, argc, argv,
+                          "resultsfile [pctnumber [stations]]");
+
+  string filename = static_cast<string>(argv[1]);
+  int pct_number = -1;
+  int station_count = -1;
+  if (argc > 2)
+    pct_number = Utils::StringToInteger(static_cast<string>(argv[2]));
+  if (argc > 3)
+    station_count = Utils::StringToInteger(static_cast<string>(argv[3]));
+
+  if (VoterTrace::IsTrace(filename)) {
+    VoterTrace::Print(filename, pct_number, station_count, cout);
+    return 0;
+  }
+
+  ResultStore store;
+  store.Open(filename);
+
+  int first = 0;
+  int last = store.GetIndexCount();
+  if (pct_number >= 0) {
+    if (station_count >= 0) {
+      first = store.LowerBoundEntry(pct_number, station_count);
+      last = store.LowerBoundEntry(pct_number, station_count + 1);
+    } else {
+      first = store.LowerBoundEntry(pct_number, 0);
+      last = store.LowerBoundEntry(pct_number, INT_MAX);
+    }
+  }
+
+  Formatter line;
+  for (int sub = first; sub < last; ++sub) {
+    const ResultIndexEntry& entry = store.GetEntry(sub);
+    string name = store.GetName(entry);
+    for (UINT row = 0; row < entry.row_count; ++row) {
+      line.Clear();
+      ResultStore::AppendLine(line, kReportTag, store.GetRow(entry, row),
+                              name);
+      cout << line.GetString();
+    }
+  }
+
+  store.Close();
+  return 0;
+}
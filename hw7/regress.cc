@@ -0,0 +1,483 @@
+/*******************************************************************************
+ * Main program for the golden output and performance regression harness.
+ *
+ * Runs Aprog on a fixed set of cases and fails if any answer changed or if
+ * any case became slower or bigger than its stored baseline:
+ *
+ *   Hprog casefile [--runs=N] [--aprog=PATH] [--update-golden]
+ *         [--update-baseline]
+ *
+ * Each line of 'casefile' that is not blank or a '#' comment is one case:
+ *   name golden configfile pctfile [Aprog options]
+ * Its output file and log must match 'golden.out' and 'golden.log' in the
+ * directory of 'casefile', except for the lines that differ from run to run
+ * (the TIME report and the names of the output file and log). Cases whose
+ * answers must not depend on an option, such as the thread count, share a
+ * golden. 'make regress' runs 'golden/cases.txt'.
+ *
+ * Every case is run N times (default 5), with its files in 'name.out.new' and
+ * 'name.log.new', which are kept only if they do not match. Each run's wall
+ * time, CPU time (user and system, all threads) and peak resident size come
+ * from the clock and 'wait4'. The medians, and the median absolute
+ * deviations of the times, are compared with the case's line in
+ * 'baseline.txt'.
+ *
+ * Shared machines run tens of percent faster or slower from one minute to
+ * the next, so before every run a fixed piece of work is timed as well, and
+ * the baseline's times are scaled by how much longer (or shorter) its median
+ * took now than when the baseline was measured. A time then regresses if its
+ * median is above
+ *   baseline median + max(kRelativeSlack * baseline median,
+ *                         kMadSlack * the larger of the two MADs,
+ *                         kAbsoluteSlack)
+ * so a noisy case needs a bigger change to fail than a steady one, and a
+ * tiny one cannot fail on clock jitter. The peak resident size regresses if
+ * it grows by more than kRelativeSlack and kRssSlackKb together.
+ *
+ * The baseline belongs to the machine it was measured on. '--update-baseline'
+ * rewrites it from this run, and '--update-golden' rewrites the golden
+ * files, after a change that was meant to change the answers.
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+static const string kTag = "REGRESS: ";
+static const int kDefaultRuns = 5;
+static const double kRelativeSlack = 0.15;
+static const double kMadSlack = 4.0;
+static const double kAbsoluteSlack = 0.020;
+static const LONG kRssSlackKb = 1024;
+static const int kCalibrationValues = 250000;
+
+// The calibration's result is added here so it cannot be optimized away
+static volatile unsigned calibration_sink = 0;
+
+/*******************************************************************************
+ * One case, from a line of the case file.
+**/
+struct RegressCase {
+  string name;
+  string golden;
+  vector<string> args;
+};
+
+/*******************************************************************************
+ * What the runs of a case measured, or what the baseline says they did.
+**/
+struct RegressNumbers {
+  double wall_median = 0.0;
+  double wall_mad = 0.0;
+  double cpu_median = 0.0;
+  double cpu_mad = 0.0;
+  LONG rss_kb = 0;
+  double calibration = 0.0;
+};
+
+/*******************************************************************************
+ * The median of 'values', which are sorted in place.
+**/
+static double Median(vector<double>& values) {
+  sort(values.begin(), values.end());
+  int count = static_cast<int>(values.size());
+  if (0 == count % 2)
+    return (values.at(count / 2 - 1) + values.at(count / 2)) / 2.0;
+  return values.at(count / 2);
+}
+
+/*******************************************************************************
+ * The median absolute deviation of 'values' from 'median'.
+**/
+static double MedianDeviation(const vector<double>& values, double median) {
+  vector<double> deviations;
+  for (double value : values) {
+    deviations.push_back(value > median ? value - median : median - value);
+  }
+  return Median(deviations);
+}
+
+/*******************************************************************************
+ * The directory part of 'filename', ending in '/', or "" if it has none.
+**/
+static string DirectoryOf(const string& filename) {
+  string::size_type slash = filename.rfind("/");
+  if (slash == string::npos)
+    return "";
+  return filename.substr(0, slash + 1);
+}
+
+/*******************************************************************************
+ * Times a fixed piece of work, random numbers and a sort, that stands in for
+ * how fast the machine is just now.
+ *
+ * Returns:
+ *   the seconds it took
+**/
+static double TimeCalibration() {
+  auto start = chrono::steady_clock::now();
+  mt19937 generator(kCalibrationValues);
+  vector<unsigned> values(kCalibrationValues);
+  for (unsigned& value : values) {
+    value = generator();
+  }
+  sort(values.begin(), values.end());
+  calibration_sink = calibration_sink + values.at(kCalibrationValues / 2);
+  return chrono::duration<double>(chrono::steady_clock::now() - start)
+         .count();
+}
+
+/*******************************************************************************
+ * Reads the cases, exiting on a line with too few fields.
+**/
+static vector<RegressCase> ReadCases(const string& filename) {
+  vector<RegressCase> cases;
+  ifstream in_stream;
+  Utils::FileOpen(in_stream, filename);
+  string line;
+  int line_number = 0;
+  while (getline(in_stream, line)) {
+    ++line_number;
+    istringstream fields(line);
+    RegressCase one_case;
+    if (!(fields >> one_case.name) || ('#' == one_case.name.at(0)))
+      continue;
+    string field;
+    fields >> one_case.golden;
+    while (fields >> field) {
+      one_case.args.push_back(field);
+    }
+    if (one_case.args.size() < 2) {
+      cout << kTag << filename << " line " << line_number
+           << ": need name golden configfile pctfile [options]" << endl;
+      exit(1);
+    }
+    cases.push_back(one_case);
+  }
+  Utils::FileClose(in_stream);
+  return cases;
+}
+
+/*******************************************************************************
+ * Reads the baseline, if there is one, into a map from case name.
+**/
+static map<string, RegressNumbers> ReadBaseline(const string& filename) {
+  map<string, RegressNumbers> baseline;
+  ifstream in_stream(filename.c_str());
+  string line;
+  while (getline(in_stream, line)) {
+    istringstream fields(line);
+    string name;
+    RegressNumbers numbers;
+    if (!(fields >> name) || ('#' == name.at(0)))
+      continue;
+    if (fields >> numbers.wall_median >> numbers.wall_mad
+               >> numbers.cpu_median >> numbers.cpu_mad >> numbers.rss_kb
+               >> numbers.calibration)
+      baseline[name] = numbers;
+  }
+  return baseline;
+}
+
+static void WriteBaseline(const string& filename,
+                          const vector<RegressCase>& cases,
+                          const map<string, RegressNumbers>& measured) {
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  out_stream << "# case wall_median wall_mad cpu_median cpu_mad rss_kb"
+             << " calibration\n";
+  for (const RegressCase& one_case : cases) {
+    const RegressNumbers& numbers = measured.at(one_case.name);
+    Formatter line;
+    line.AppendLeft(one_case.name, 20);
+    line.AppendFixed(numbers.wall_median, 10, 4);
+    line.AppendFixed(numbers.wall_mad, 10, 4);
+    line.AppendFixed(numbers.cpu_median, 10, 4);
+    line.AppendFixed(numbers.cpu_mad, 10, 4);
+    line.AppendInt(numbers.rss_kb, 10);
+    line.AppendFixed(numbers.calibration, 12, 6);
+    out_stream << line.GetString() << "\n";
+  }
+  Utils::FileClose(out_stream);
+}
+
+/*******************************************************************************
+ * The lines of 'filename' that should be the same on every run.
+**/
+static vector<string> ReadStableLines(const string& filename) {
+  vector<string> lines;
+  ifstream in_stream(filename.c_str());
+  string line;
+  while (getline(in_stream, line)) {
+    if ((0 == line.compare(0, 4, "TIME")) ||
+        (0 == line.compare(0, 14, "MAIN: outfile ")) ||
+        (0 == line.compare(0, 14, "MAIN: logfile ")))
+      continue;
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+static void WriteLines(const string& filename, const vector<string>& lines) {
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  for (const string& line : lines) {
+    out_stream << line << "\n";
+  }
+  Utils::FileClose(out_stream);
+}
+
+/*******************************************************************************
+ * Compares the stable lines of a run's file with its golden file.
+ *
+ * Returns:
+ *   "" if they match, else where and how they first differ
+**/
+static string CompareWithGolden(const string& filename,
+                                const string& golden_filename) {
+  ifstream golden_stream(golden_filename.c_str());
+  if (!golden_stream)
+    return "no golden file '" + golden_filename + "'";
+  golden_stream.close();
+
+  vector<string> run_lines = ReadStableLines(filename);
+  vector<string> golden_lines = ReadStableLines(golden_filename);
+  UINT common = min(run_lines.size(), golden_lines.size());
+  for (UINT sub = 0; sub < common; ++sub) {
+    if (run_lines.at(sub) != golden_lines.at(sub))
+      return "line " + to_string(sub + 1) + " differs\n  golden: "
+             + golden_lines.at(sub) + "\n  now:    " + run_lines.at(sub);
+  }
+  if (run_lines.size() != golden_lines.size())
+    return to_string(run_lines.size()) + " lines where the golden file has "
+           + to_string(golden_lines.size());
+  return "";
+}
+
+/*******************************************************************************
+ * Runs Aprog once, with its standard output thrown away, and measures it.
+ *
+ * Returns:
+ *   false if it could not be run or did not exit with 0
+**/
+static bool RunOnce(const string& aprog, const RegressCase& one_case,
+                    const string& out_filename, const string& log_filename,
+                    double& wall, double& cpu, LONG& rss_kb) {
+  vector<string> args = {aprog, one_case.args.at(0), one_case.args.at(1),
+                         out_filename, log_filename};
+  args.insert(args.end(), one_case.args.begin() + 2, one_case.args.end());
+  vector<char*> argv;
+  for (string& arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  argv.push_back(nullptr);
+
+  auto start = chrono::steady_clock::now();
+  pid_t child = fork();
+  if (child < 0)
+    return false;
+  if (0 == child) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0)
+      dup2(null_fd, STDOUT_FILENO);
+    execv(aprog.c_str(), argv.data());
+    _exit(127);
+  }
+
+  int status = 0;
+  struct rusage usage;
+  if (wait4(child, &status, 0, &usage) != child)
+    return false;
+  wall = chrono::duration<double>(chrono::steady_clock::now() - start)
+         .count();
+  cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+        + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+  rss_kb = usage.ru_maxrss;
+  return WIFEXITED(status) && (0 == WEXITSTATUS(status));
+}
+
+/*******************************************************************************
+ * Whether a time has regressed from the baseline, by the rule above.
+**/
+static bool TimeRegressed(double median, double mad, double base_median,
+                          double base_mad) {
+  double slack = max(kRelativeSlack * base_median,
+                     max(kMadSlack * max(mad, base_mad), kAbsoluteSlack));
+  return median > base_median + slack;
+}
+
+/*******************************************************************************
+ * Main program.
+**/
+int main(int argc, char *argv[]) {
+  Utils::CheckArgsAtLeast(1, argc, argv,
+                          "casefile [--runs=N] [--aprog=PATH]"
+                          " [--update-golden] [--update-baseline]");
+  string case_filename = static_cast<string>(argv[1]);
+  int runs = kDefaultRuns;
+  string aprog = "./Aprog";
+  bool update_golden = false;
+  bool update_baseline = false;
+  for (int sub = 2; sub < argc; ++sub) {
+    string option = static_cast<string>(argv[sub]);
+    if (0 == option.compare(0, 7, "--runs=")) {
+      runs = max(1, Utils::StringToInteger(option.substr(7)));
+    } else if (0 == option.compare(0, 8, "--aprog=")) {
+      aprog = option.substr(8);
+    } else if ("--update-golden" == option) {
+      update_golden = true;
+    } else if ("--update-baseline" == option) {
+      update_baseline = true;
+    } else {
+      cout << kTag << "unknown option '" << option << "'" << endl;
+      cout << kTag << "options: --runs=N --aprog=PATH --update-golden"
+           << " --update-baseline" << endl;
+      exit(1);
+    }
+  }
+
+  string dir = DirectoryOf(case_filename);
+  string baseline_filename = dir + "baseline.txt";
+  vector<RegressCase> cases = ReadCases(case_filename);
+  map<string, RegressNumbers> baseline = ReadBaseline(baseline_filename);
+  map<string, RegressNumbers> measured;
+  set<string> goldens_written;
+  int failures = 0;
+
+  for (const RegressCase& one_case : cases) {
+    string out_filename = dir + one_case.name + ".out.new";
+    string log_filename = dir + one_case.name + ".log.new";
+    string golden_out = dir + one_case.golden + ".out";
+    string golden_log = dir + one_case.golden + ".log";
+
+    vector<double> walls;
+    vector<double> cpus;
+    vector<double> calibrations;
+    LONG rss_kb = 0;
+    bool ran = true;
+    string mismatch = "";
+    for (int run = 0; run < runs; ++run) {
+      double wall = 0.0;
+      double cpu = 0.0;
+      LONG run_rss_kb = 0;
+      calibrations.push_back(TimeCalibration());
+      if (!RunOnce(aprog, one_case, out_filename, log_filename,
+                   wall, cpu, run_rss_kb)) {
+        ran = false;
+        break;
+      }
+      walls.push_back(wall);
+      cpus.push_back(cpu);
+      rss_kb = max(rss_kb, run_rss_kb);
+
+      // Only the first case that names a golden writes it, so the others
+      // are still checked against it. Every run is compared, so an answer
+      // that changes from run to run is caught too.
+      if (update_golden && (0 == run) &&
+          goldens_written.insert(one_case.golden).second) {
+        WriteLines(golden_out, ReadStableLines(out_filename));
+        WriteLines(golden_log, ReadStableLines(log_filename));
+      }
+      if (mismatch.empty())
+        mismatch = CompareWithGolden(out_filename, golden_out);
+      if (mismatch.empty())
+        mismatch = CompareWithGolden(log_filename, golden_log);
+    }
+
+    if (!ran) {
+      cout << kTag << "FAIL " << one_case.name << ": '" << aprog
+           << "' did not run to the end" << endl;
+      ++failures;
+      continue;
+    }
+
+    RegressNumbers numbers;
+    numbers.wall_median = Median(walls);
+    numbers.wall_mad = MedianDeviation(walls, numbers.wall_median);
+    numbers.cpu_median = Median(cpus);
+    numbers.cpu_mad = MedianDeviation(cpus, numbers.cpu_median);
+    numbers.rss_kb = rss_kb;
+    numbers.calibration = Median(calibrations);
+    measured[one_case.name] = numbers;
+
+    Formatter line;
+    line.Append(kTag);
+    line.AppendLeft(one_case.name, 20);
+    line.Append(" wall");
+    line.AppendFixed(numbers.wall_median, 8, 4);
+    line.Append(" +-");
+    line.AppendFixed(numbers.wall_mad, 7, 4);
+    line.Append("  cpu");
+    line.AppendFixed(numbers.cpu_median, 8, 4);
+    line.Append(" +-");
+    line.AppendFixed(numbers.cpu_mad, 7, 4);
+    line.Append("  rss");
+    line.AppendInt(numbers.rss_kb, 8);
+    line.Append(" KB");
+
+    vector<string> problems;
+    if (!mismatch.empty())
+      problems.push_back("output changed: " + mismatch);
+    auto base = baseline.find(one_case.name);
+    if (base == baseline.end()) {
+      if (!update_baseline)
+        line.Append("  (no baseline)");
+    } else if (!update_baseline) {
+      // The baseline's times as they would be on the machine as fast as it
+      // is now
+      const RegressNumbers& was = base->second;
+      double scale = 1.0;
+      if ((was.calibration > 0.0) && (numbers.calibration > 0.0))
+        scale = numbers.calibration / was.calibration;
+      line.Append("  scale");
+      line.AppendFixed(scale, 6, 2);
+      if (TimeRegressed(numbers.wall_median, numbers.wall_mad,
+                        scale * was.wall_median, scale * was.wall_mad))
+        problems.push_back("wall time regressed from "
+                           + Utils::Format(scale * was.wall_median, 0, 4)
+                           + " s");
+      if (TimeRegressed(numbers.cpu_median, numbers.cpu_mad,
+                        scale * was.cpu_median, scale * was.cpu_mad))
+        problems.push_back("CPU time regressed from "
+                           + Utils::Format(scale * was.cpu_median, 0, 4)
+                           + " s");
+      if (numbers.rss_kb > was.rss_kb * (1.0 + kRelativeSlack) + kRssSlackKb)
+        problems.push_back("peak RSS grew from "
+                           + to_string(was.rss_kb) + " KB");
+    }
+
+    line.Append(problems.empty() ? "  ok" : "  FAIL");
+    cout << line.GetString() << endl;
+    for (const string& problem : problems) {
+      cout << kTag << "  " << problem << endl;
+    }
+    if (problems.empty()) {
+      remove(out_filename.c_str());
+      remove(log_filename.c_str());
+    } else {
+      ++failures;
+    }
+  }
+
+  if (update_baseline && (0 == failures)) {
+    WriteBaseline(baseline_filename, cases, measured);
+    cout << kTag << "wrote '" << baseline_filename << "'" << endl;
+  }
+  cout << kTag << cases.size() - failures << " of " << cases.size()
+       << " cases passed" << endl;
+  return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+#include "resultstore.h"
+/*******************************************************************************
+ * Implementation for the 'ResultStore' class.
+**/
+
+static const string kTag = "RESULTS: ";
+
+/*******************************************************************************
+ * Constructor.
+**/
+ResultStore::ResultStore() {
+}
+
+/*******************************************************************************
+ * Destructor.
+**/
+ResultStore::~ResultStore() {
+}
+
+/*******************************************************************************
+ * Accessors and mutators.
+**/
+int ResultStore::GetIndexCount() const {
+  return static_cast<int>(trailer_->index_count);
+}
+
+/*******************************************************************************
+ * Returns an index entry out of the mapped file, after checking that its rows
+ * are inside the store and that it comes after the entry before it. The
+ * entries are checked as they are used rather than all at 'Open', so reading
+ * one precinct from a big store stays cheap.
+**/
+const ResultIndexEntry& ResultStore::GetEntry(int sub) const {
+  const ResultIndexEntry& entry = this->GetRawEntry(sub);
+  if (entry.first_row + entry.row_count > trailer_->row_count)
+    Fail(filename_, "has an index entry past the last row");
+  if (sub == 0)
+    return entry;
+  const ResultIndexEntry& previous = this->GetRawEntry(sub - 1);
+  if ((previous.pct_number > entry.pct_number) ||
+      ((previous.pct_number == entry.pct_number) &&
+       (previous.station_count > entry.station_count)))
+    Fail(filename_, "has its index out of order");
+  return entry;
+}
+
+string ResultStore::GetName(const ResultIndexEntry& entry) const {
+  return string(entry.name, strnlen(entry.name, kResultNameBytes));
+}
+
+/*******************************************************************************
+ * Gathers one row from its block, one value from each column.
+**/
+ResultRow ResultStore::GetRow(const ResultIndexEntry& entry, int sub) const {
+  assert((sub >= 0) && (static_cast<uint64_t>(sub) < entry.row_count));
+  LONG row_number = static_cast<LONG>(entry.first_row) + sub;
+  this->CheckBlock(row_number);
+
+  ResultRow row;
+  row.pct_number = entry.pct_number;
+  row.station_count = entry.station_count;
+  row.expected_voters = entry.expected_voters;
+
+  LONG iteration = 0;
+  memcpy(&iteration, GetColumn(row_number, kResultIteration), sizeof(LONG));
+  row.iteration = static_cast<int>(iteration);
+  memcpy(&row.mean_seconds, GetColumn(row_number, kResultMeanSeconds),
+         sizeof(double));
+  memcpy(&row.dev_seconds, GetColumn(row_number, kResultDevSeconds),
+         sizeof(double));
+  for (int which = 0; which < 3; ++which) {
+    memcpy(&row.too_long[which], GetColumn(row_number, kResultTooLong + which),
+           sizeof(LONG));
+  }
+  for (int which = 0; which < 4; ++which) {
+    memcpy(&row.quantiles[which],
+           GetColumn(row_number, kResultQuantiles + which), sizeof(LONG));
+  }
+  return row;
+}
+
+LONG ResultStore::GetRowCount() const {
+  return static_cast<LONG>(trailer_->row_count);
+}
+
+/*******************************************************************************
+ * Returns the subscript of the first index entry at or after 'pct_number' and
+ * 'station_count', or GetIndexCount() if there is none, by binary search.
+ * Only the entries probed are read; 'GetEntry' checks the ones the caller
+ * then reads.
+**/
+int ResultStore::LowerBoundEntry(int pct_number, int station_count) const {
+  int low = 0;
+  int high = this->GetIndexCount();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    const ResultIndexEntry& entry = this->GetRawEntry(mid);
+    if ((entry.pct_number < pct_number) ||
+        ((entry.pct_number == pct_number) &&
+         (entry.station_count < station_count)))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/*******************************************************************************
+ * General functions.
+**/
+
+/*******************************************************************************
+ * Function 'AppendLine'.
+ * Formats the line OnePct::ReportStatistics writes for one iteration. Both
+ * Aprog and the reader use this, so the text from the store is the same.
+**/
+void ResultStore::AppendLine(Formatter& line, const string& tag,
+                             const ResultRow& row, const string& name) {
+  double expected = static_cast<double>(row.expected_voters);
+
+  line.Append(tag);
+  line.AppendInt(row.iteration, 3);
+  line.Append(" ");
+  line.AppendInt(row.pct_number, 4);
+  line.Append(" ");
+  line.AppendLeft(name, 25);
+  line.AppendInt(row.expected_voters, 6);
+  line.AppendInt(row.station_count, 4);
+  line.Append(" stations, mean/dev wait (mins) ");
+  line.AppendFixed(row.mean_seconds / 60.0, 8, 2);
+  line.Append(" ");
+  line.AppendFixed(row.dev_seconds / 60.0, 8, 2);
+  line.Append(" toolong ");
+  for (int sub = 0; sub < 3; ++sub) {
+    line.AppendInt(row.too_long[sub], 6);
+    line.Append(" ");
+    line.AppendFixed(100.0 * row.too_long[sub] / expected, 6, 2);
+  }
+  line.Append(" p50/90/95/99 ");
+  for (int sub = 0; sub < 4; ++sub) {
+    line.AppendFixed(row.quantiles[sub] / 60.0, 8, 2);
+  }
+  line.Append("\n");
+}
+
+/*******************************************************************************
+ * Function 'Open'.
+ * Maps a store and checks that it is one this program wrote: the magic
+ * numbers, version and column count must agree, and the block offsets and
+ * the index must be inside the file. This reads only the header and trailer,
+ * so it costs the same for any size of store; each index entry and block is
+ * checked when 'GetEntry' or 'GetRow' first uses it. Anything wrong is
+ * reported and stops the program, the same as a bad input bundle.
+**/
+void ResultStore::Open(const string& filename) {
+  filename_ = filename;
+  if (!file_.Open(filename))
+    Fail(filename, "cannot be mapped");
+  uint64_t size = file_.GetSize();
+  if (size < sizeof(ResultHeader) + sizeof(ResultTrailer))
+    Fail(filename, "is too short to be a results store");
+
+  const ResultHeader* header = reinterpret_cast<const ResultHeader*>(
+                               file_.GetData());
+  if (0 != memcmp(header->magic, kResultMagic, sizeof(kResultMagic)))
+    Fail(filename, "is not a results store");
+  if (kResultVersion != header->version)
+    Fail(filename, "is results version " + Utils::Format(
+                   static_cast<int>(header->version)) + ", not " +
+                   Utils::Format(static_cast<int>(kResultVersion)));
+  if ((sizeof(ResultHeader) != header->header_bytes) ||
+      (kResultColumnCount != static_cast<int>(header->column_count)) ||
+      (0 == header->block_rows))
+    Fail(filename, "has the wrong layout");
+
+  uint64_t trailer_offset = size - sizeof(ResultTrailer);
+  trailer_ = reinterpret_cast<const ResultTrailer*>(file_.GetData()
+                                                    + trailer_offset);
+  if (0 != memcmp(trailer_->magic, kResultMagic, sizeof(kResultMagic)))
+    Fail(filename, "was not finished");
+
+  uint64_t block_rows = header->block_rows;
+  if (trailer_->block_count !=
+      (trailer_->row_count + block_rows - 1) / block_rows)
+    Fail(filename, "has the wrong number of blocks");
+  if ((trailer_->block_offsets_offset
+       + trailer_->block_count * sizeof(uint64_t) > trailer_offset) ||
+      (trailer_->index_offset
+       + trailer_->index_count * sizeof(ResultIndexEntry) > trailer_offset))
+    Fail(filename, "has a section past the end of the file");
+}
+
+/*******************************************************************************
+ * Function 'Close'.
+**/
+void ResultStore::Close() {
+  file_.Close();
+  trailer_ = nullptr;
+}
+
+/*******************************************************************************
+ * Stops the program if the block holding row 'row' runs past the end of the
+ * data, which is where the block offsets start.
+**/
+void ResultStore::CheckBlock(LONG row) const {
+  const ResultHeader* header = reinterpret_cast<const ResultHeader*>(
+                               file_.GetData());
+  uint64_t block_rows = header->block_rows;
+  uint64_t block = static_cast<uint64_t>(row) / block_rows;
+  uint64_t rows = trailer_->row_count - block * block_rows;
+  if (rows > block_rows)
+    rows = block_rows;
+
+  const uint64_t* block_offsets = reinterpret_cast<const uint64_t*>(
+                                  file_.GetData()
+                                  + trailer_->block_offsets_offset);
+  if (block_offsets[block] + rows * kResultColumnCount * sizeof(LONG)
+      > trailer_->block_offsets_offset)
+    Fail(filename_, "has a block past the end of the data");
+}
+
+/*******************************************************************************
+ * Where the value of 'column' for row 'row' is in the mapped file. A block
+ * holds 'block_rows' rows except perhaps the last, and its columns are each
+ * as long as its rows.
+**/
+const char* ResultStore::GetColumn(LONG row, int column) const {
+  const ResultHeader* header = reinterpret_cast<const ResultHeader*>(
+                               file_.GetData());
+  uint64_t block_rows = header->block_rows;
+  uint64_t block = static_cast<uint64_t>(row) / block_rows;
+  uint64_t in_block = static_cast<uint64_t>(row) % block_rows;
+  uint64_t rows = trailer_->row_count - block * block_rows;
+  if (rows > block_rows)
+    rows = block_rows;
+
+  const uint64_t* block_offsets = reinterpret_cast<const uint64_t*>(
+                                  file_.GetData()
+                                  + trailer_->block_offsets_offset);
+  return file_.GetData() + block_offsets[block]
+         + (column * rows + in_block) * sizeof(LONG);
+}
+
+/*******************************************************************************
+ * Returns an index entry straight out of the mapped file, unchecked.
+**/
+const ResultIndexEntry& ResultStore::GetRawEntry(int sub) const {
+  assert((sub >= 0) && (sub < this->GetIndexCount()));
+  const ResultIndexEntry* index = reinterpret_cast<const ResultIndexEntry*>(
+                                  file_.GetData() + trailer_->index_offset);
+  return index[sub];
+}
+
+/*******************************************************************************
+ * Report a bad store and stop.
+**/
+void ResultStore::Fail(const string& filename, const string& why) const {
+  cout << kTag << "ERROR: '" << filename << "' " << why << endl;
+  exit(0);
+}
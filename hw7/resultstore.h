@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * Header for the 'ResultStore' class.
+ *
+ * A results store is a binary file of the numbers behind each per-iteration
+ * line of the report, written by a 'ResultWriter' as Aprog runs with
+ * '--results=FILE' and read back by mapping it with a 'ResultStore'.
+ *
+ * Layout (native byte order, everything 8 byte aligned):
+ *   ResultHeader
+ *   blocks of up to 'block_rows' rows each, stored by column: all the
+ *     iterations, then all the means, and so on, kResultColumnCount
+ *     columns of 8 byte values
+ *   uint64_t          block_offsets[block_count]
+ *   ResultIndexEntry  index[index_count]
+ *   ResultTrailer
+ *
+ * Each index entry is one precinct at one station count, with the rows of its
+ * iterations, which are consecutive. The index is sorted by precinct and
+ * station count, so 'LowerBoundEntry' is a binary search, and a row's block and
+ * place in it follow from its number, so any one value is found without
+ * reading anything else. The trailer is at the end because the writer only
+ * knows the index once every row has gone by.
+**/
+
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/mappedfile.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+static const char kResultMagic[8] = {'A', 'P', 'R', 'O', 'G', 'R', 'E', 'S'};
+static const uint32_t kResultVersion = 1;
+static const int kResultBlockRows = 4096;
+static const int kResultNameBytes = 32;
+
+// The columns of a block, in the order they are stored
+static const int kResultIteration = 0;
+static const int kResultMeanSeconds = 1;
+static const int kResultDevSeconds = 2;
+static const int kResultTooLong = 3;        // 3 columns: +0, +10, +20 minutes
+static const int kResultQuantiles = 6;      // 4 columns: p50, p90, p95, p99
+static const int kResultColumnCount = 10;
+
+/*******************************************************************************
+ * The numbers on one per-iteration line of the report.
+**/
+struct ResultRow {
+  int pct_number = 0;
+  int station_count = 0;
+  int expected_voters = 0;
+  int iteration = 0;
+  double mean_seconds = 0.0;
+  double dev_seconds = 0.0;
+  LONG too_long[3] = {0, 0, 0};
+  LONG quantiles[4] = {0, 0, 0, 0};
+};
+
+struct ResultHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_bytes;
+  uint32_t column_count;
+  uint32_t block_rows;
+};
+
+struct ResultIndexEntry {
+  int32_t pct_number;
+  int32_t station_count;
+  int32_t expected_voters;
+  int32_t unused;
+  uint64_t first_row;
+  uint64_t row_count;
+  char name[kResultNameBytes];
+};
+
+struct ResultTrailer {
+  uint64_t row_count;
+  uint64_t block_count;
+  uint64_t block_offsets_offset;
+  uint64_t index_offset;
+  uint64_t index_count;
+  char magic[8];
+};
+
+class ResultStore {
+public:
+/*******************************************************************************
+ * Constructors and destructors for the class.
+**/
+ ResultStore();
+ virtual ~ResultStore();
+
+/*******************************************************************************
+ * Accessors and Mutators.
+**/
+ int GetIndexCount() const;
+ const ResultIndexEntry& GetEntry(int sub) const;
+ string GetName(const ResultIndexEntry& entry) const;
+ // Row 'sub' of the rows of an entry, 0 for its first iteration
+ ResultRow GetRow(const ResultIndexEntry& entry, int sub) const;
+ LONG GetRowCount() const;
+ // Subscript of the first entry at or after this precinct and station count
+ int LowerBoundEntry(int pct_number, int station_count) const;
+
+/*******************************************************************************
+ * General functions.
+**/
+ // The per-iteration report line for a row, exactly as Aprog writes it
+ static void AppendLine(Formatter& line, const string& tag,
+                        const ResultRow& row, const string& name);
+ // Maps a store and checks its header and trailer; entries and blocks are
+ // checked as they are read
+ void Open(const string& filename);
+ void Close();
+
+private:
+ string filename_;
+ MappedFile file_;
+ const ResultTrailer* trailer_ = nullptr;
+
+ void CheckBlock(LONG row) const;
+ const char* GetColumn(LONG row, int column) const;
+ const ResultIndexEntry& GetRawEntry(int sub) const;
+ void Fail(const string& filename, const string& why) const;
+};
+
+#endif // RESULTSTORE_H
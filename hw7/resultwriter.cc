@@ -0,0 +1,153 @@
+#include "resultwriter.h"
+/*******************************************************************************
+ * Implementation for the 'ResultWriter' class.
+**/
+
+/*******************************************************************************
+ * Constructor.
+**/
+ResultWriter::ResultWriter() {
+}
+
+/*******************************************************************************
+ * Destructor.
+**/
+ResultWriter::~ResultWriter() {
+  this->Close();
+}
+
+/*******************************************************************************
+ * Accessors and mutators.
+**/
+bool ResultWriter::IsOpen() const {
+  return is_open_;
+}
+
+/*******************************************************************************
+ * General functions.
+**/
+
+/*******************************************************************************
+ * Function 'Append'.
+ * Adds the rows to the block, writing it out each time it fills, and extends
+ * the index entry of the rows' precinct and station count or starts a new
+ * one. A name too long for the index is cut short; it is only a label.
+**/
+void ResultWriter::Append(const vector<ResultRow>& rows, const string& name) {
+  for (UINT sub = 0; sub < rows.size(); ++sub) {
+    const ResultRow& row = rows.at(sub);
+
+    if (index_.empty() || (index_.back().pct_number != row.pct_number) ||
+        (index_.back().station_count != row.station_count) ||
+        (index_.back().first_row + index_.back().row_count != row_count_)) {
+      ResultIndexEntry entry;
+      memset(&entry, 0, sizeof(entry));
+      entry.pct_number = row.pct_number;
+      entry.station_count = row.station_count;
+      entry.expected_voters = row.expected_voters;
+      entry.first_row = row_count_;
+      memcpy(entry.name, name.data(),
+             min(name.length(), static_cast<size_t>(kResultNameBytes)));
+      index_.push_back(entry);
+    }
+    ++index_.back().row_count;
+
+    LONG values[kResultColumnCount];
+    values[kResultIteration] = row.iteration;
+    memcpy(&values[kResultMeanSeconds], &row.mean_seconds, sizeof(double));
+    memcpy(&values[kResultDevSeconds], &row.dev_seconds, sizeof(double));
+    for (int which = 0; which < 3; ++which) {
+      values[kResultTooLong + which] = row.too_long[which];
+    }
+    for (int which = 0; which < 4; ++which) {
+      values[kResultQuantiles + which] = row.quantiles[which];
+    }
+    for (int column = 0; column < kResultColumnCount; ++column) {
+      block_[column].push_back(values[column]);
+    }
+
+    ++row_count_;
+    if (static_cast<int>(block_[0].size()) == kResultBlockRows)
+      this->WriteBlock();
+  }
+}
+
+/*******************************************************************************
+ * Function 'Close'.
+ * Writes the last block, then the block offsets, the index sorted by precinct
+ * and station count, and the trailer that says where they are.
+**/
+void ResultWriter::Close() {
+  if (!is_open_)
+    return;
+
+  this->WriteBlock();
+
+  stable_sort(index_.begin(), index_.end(),
+              [](const ResultIndexEntry& a, const ResultIndexEntry& b) {
+                if (a.pct_number != b.pct_number)
+                  return a.pct_number < b.pct_number;
+                return a.station_count < b.station_count;
+              });
+
+  ResultTrailer trailer;
+  memset(&trailer, 0, sizeof(trailer));
+  trailer.row_count = row_count_;
+  trailer.block_count = block_offsets_.size();
+  trailer.block_offsets_offset = bytes_written_;
+  if (!block_offsets_.empty())
+    this->WriteBytes(block_offsets_.data(),
+                     block_offsets_.size() * sizeof(uint64_t));
+  trailer.index_offset = bytes_written_;
+  trailer.index_count = index_.size();
+  if (!index_.empty())
+    this->WriteBytes(index_.data(), index_.size() * sizeof(ResultIndexEntry));
+  memcpy(trailer.magic, kResultMagic, sizeof(kResultMagic));
+  this->WriteBytes(&trailer, sizeof(trailer));
+
+  Utils::FileClose(out_stream_);
+  is_open_ = false;
+  block_offsets_.clear();
+  index_.clear();
+}
+
+/*******************************************************************************
+ * Function 'Open'.
+ * Starts a new store with its header.
+**/
+void ResultWriter::Open(const string& filename) {
+  assert(!is_open_);
+  Utils::FileOpen(out_stream_, filename);
+  is_open_ = true;
+  bytes_written_ = 0;
+  row_count_ = 0;
+
+  ResultHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kResultMagic, sizeof(kResultMagic));
+  header.version = kResultVersion;
+  header.header_bytes = sizeof(ResultHeader);
+  header.column_count = kResultColumnCount;
+  header.block_rows = kResultBlockRows;
+  this->WriteBytes(&header, sizeof(header));
+}
+
+/*******************************************************************************
+ * Writes the rows held so far as one block, column after column.
+**/
+void ResultWriter::WriteBlock() {
+  if (block_[0].empty())
+    return;
+
+  block_offsets_.push_back(bytes_written_);
+  for (int column = 0; column < kResultColumnCount; ++column) {
+    this->WriteBytes(block_[column].data(),
+                     block_[column].size() * sizeof(LONG));
+    block_[column].clear();
+  }
+}
+
+void ResultWriter::WriteBytes(const void* data, size_t size) {
+  out_stream_.write(static_cast<const char*>(data), size);
+  bytes_written_ += size;
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Header for the 'ResultWriter' class.
+ *
+ * A 'ResultWriter' appends rows to a results store (see 'ResultStore' for the
+ * layout) as they come. It holds one block of rows, by column, and writes the
+ * block when it is full, so its memory does not grow with the run. Only the
+ * block offsets and the index, one entry per precinct and station count, are
+ * kept to the end, when 'Close' sorts the index and writes it after the last
+ * block. A store that was never closed has no trailer and will not open.
+**/
+
+#ifndef RESULTWRITER_H
+#define RESULTWRITER_H
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+#include "resultstore.h"
+
+class ResultWriter {
+public:
+/*******************************************************************************
+ * Constructors and destructors for the class.
+**/
+ ResultWriter();
+ ResultWriter(const ResultWriter&) = delete;
+ ResultWriter& operator=(const ResultWriter&) = delete;
+ virtual ~ResultWriter();
+
+/*******************************************************************************
+ * Accessors and Mutators.
+**/
+ bool IsOpen() const;
+
+/*******************************************************************************
+ * General functions.
+**/
+ // Appends one precinct's rows, in the order they were simulated
+ void Append(const vector<ResultRow>& rows, const string& name);
+ void Close();
+ void Open(const string& filename);
+
+private:
+ ofstream out_stream_;
+ bool is_open_ = false;
+ uint64_t bytes_written_ = 0;
+ uint64_t row_count_ = 0;
+ // The rows of the block being filled, column by column
+ vector<LONG> block_[kResultColumnCount];
+ vector<uint64_t> block_offsets_;
+ vector<ResultIndexEntry> index_;
+
+ void WriteBlock();
+ void WriteBytes(const void* data, size_t size);
+};
+
+#endif // RESULTWRITER_H
@@ -0,0 +1,258 @@
+#include "runmetrics.h"
+/*******************************************************************************
+ * Implementation for the 'RunMetrics' class.
+**/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static const string kTag = "METRICS: ";
+
+atomic<bool> RunMetrics::running_(false);
+
+static string metrics_filename = "";
+static int metrics_interval_seconds = 0;
+static int metrics_worker_count = 0;
+static atomic<LONG> pcts_known(0);
+static atomic<bool> pcts_complete(false);
+static atomic<LONG> pcts_done(0);
+static atomic<LONG> iterations_done(0);
+static atomic<LONG> voters_done(0);
+static unique_ptr<atomic<int>[]> station_depths;
+static thread_local int this_worker = 0;
+
+// Only the writing thread uses these, apart from Start and Stop
+static mutex metrics_mutex;
+static condition_variable metrics_wake;
+static bool metrics_stopping = false;
+static thread metrics_thread;
+static chrono::steady_clock::time_point start_time;
+static chrono::steady_clock::time_point last_write_time;
+static LONG last_iterations = 0;
+static LONG last_voters = 0;
+static bool ever_written = false;
+
+/*******************************************************************************
+ * Add one metric, with its help and type lines, to 'lines'.
+**/
+static void AppendMetric(Formatter& lines, const string& name,
+                         const string& help, const string& type,
+                         double value) {
+  lines.Append("# HELP " + name + " " + help + "\n");
+  lines.Append("# TYPE " + name + " " + type + "\n");
+  lines.Append(name + " ");
+  lines.AppendFixed(value, 1, (value == floor(value)) ? 0 : 3);
+  lines.Append("\n");
+}
+
+/*******************************************************************************
+ * The resident set size now, from /proc where there is one and otherwise
+ * the peak from getrusage.
+**/
+static double ResidentBytes() {
+  ifstream statm("/proc/self/statm");
+  LONG total_pages = 0;
+  LONG resident_pages = 0;
+  if (statm >> total_pages >> resident_pages)
+    return static_cast<double>(resident_pages) * sysconf(_SC_PAGESIZE);
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss * 1024.0;
+}
+
+/*******************************************************************************
+ * Accessors and mutators.
+**/
+void RunMetrics::AddPctsKnown(int count, bool complete) {
+  if (!IsRunning())
+    return;
+  pcts_known += count;
+  if (complete)
+    pcts_complete = true;
+}
+
+void RunMetrics::CountIteration(LONG voter_count) {
+  if (!IsRunning())
+    return;
+  iterations_done.fetch_add(1, memory_order_relaxed);
+  voters_done.fetch_add(voter_count, memory_order_relaxed);
+}
+
+void RunMetrics::CountPctDone() {
+  if (!IsRunning())
+    return;
+  pcts_done.fetch_add(1, memory_order_relaxed);
+}
+
+/*******************************************************************************
+ * The number of station counts this worker has tried so far on its
+ * precinct, or 0 when it is between precincts.
+**/
+void RunMetrics::SetStationDepth(int depth) {
+  if (!IsRunning())
+    return;
+  station_depths[this_worker].store(depth, memory_order_relaxed);
+}
+
+void RunMetrics::SetWorker(int worker) {
+  if ((worker >= 0) && (worker < metrics_worker_count))
+    this_worker = worker;
+}
+
+/*******************************************************************************
+ * General functions.
+**/
+
+/*******************************************************************************
+ * Function 'Start'.
+ * Writes the file once, which stops the program if it cannot be written, and
+ * starts the thread that rewrites it every 'interval_seconds'.
+**/
+void RunMetrics::Start(const string& filename, int interval_seconds,
+                       int worker_count) {
+  metrics_filename = filename;
+  metrics_interval_seconds = (interval_seconds > 0) ? interval_seconds : 1;
+  metrics_worker_count = (worker_count > 0) ? worker_count : 1;
+  station_depths.reset(new atomic<int>[metrics_worker_count]);
+  for (int worker = 0; worker < metrics_worker_count; ++worker) {
+    station_depths[worker] = 0;
+  }
+  start_time = chrono::steady_clock::now();
+  last_write_time = start_time;
+  metrics_stopping = false;
+  running_ = true;
+
+  Write(false);
+  metrics_thread = thread(&RunMetrics::Run);
+}
+
+void RunMetrics::Stop() {
+  if (!IsRunning())
+    return;
+  {
+    lock_guard<mutex> lock(metrics_mutex);
+    metrics_stopping = true;
+  }
+  metrics_wake.notify_all();
+  metrics_thread.join();
+  Write(true);
+  running_ = false;
+}
+
+/*******************************************************************************
+ * The writing thread.
+**/
+void RunMetrics::Run() {
+  unique_lock<mutex> lock(metrics_mutex);
+  while (!metrics_stopping) {
+    metrics_wake.wait_for(lock, chrono::seconds(metrics_interval_seconds));
+    if (metrics_stopping)
+      break;
+    lock.unlock();
+    Write(false);
+    lock.lock();
+  }
+}
+
+/*******************************************************************************
+ * Function 'Write'.
+ * Writes every metric to the temporary file and renames it over the metrics
+ * file. If the first write fails the program stops, as it does for a file it
+ * cannot open; a later failure is reported and the run goes on.
+**/
+void RunMetrics::Write(bool final_write) {
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  double elapsed = chrono::duration<double>(now - start_time).count();
+  double since_last = chrono::duration<double>(now - last_write_time).count();
+  LONG known = pcts_known;
+  LONG done = pcts_done;
+  LONG iterations = iterations_done;
+  LONG voters = voters_done;
+  bool complete = pcts_complete;
+
+  Formatter lines;
+  AppendMetric(lines, "aprog_precincts_done",
+               "Precincts simulated and written.", "gauge", done);
+  AppendMetric(lines, "aprog_precincts_known",
+               "Precincts read so far that will be simulated.", "gauge",
+               known);
+  AppendMetric(lines, "aprog_precincts_input_complete",
+               "1 once every precinct has been read.", "gauge",
+               complete ? 1 : 0);
+  AppendMetric(lines, "aprog_iterations_total",
+               "Iterations simulated.", "counter", iterations);
+  AppendMetric(lines, "aprog_voters_simulated_total",
+               "Voters simulated over all iterations.", "counter", voters);
+  double iteration_rate = 0.0;
+  double voter_rate = 0.0;
+  if (since_last > 0.0) {
+    iteration_rate = (iterations - last_iterations) / since_last;
+    voter_rate = (voters - last_voters) / since_last;
+  }
+  AppendMetric(lines, "aprog_iterations_per_second",
+               "Iterations per second since the last write.", "gauge",
+               iteration_rate);
+  AppendMetric(lines, "aprog_voters_per_second",
+               "Voters simulated per second since the last write.", "gauge",
+               voter_rate);
+
+  lines.Append("# HELP aprog_station_search_depth Station counts tried so"
+               " far on the worker's precinct, 0 if idle.\n");
+  lines.Append("# TYPE aprog_station_search_depth gauge\n");
+  for (int worker = 0; worker < metrics_worker_count; ++worker) {
+    lines.Append("aprog_station_search_depth{worker=\"");
+    lines.AppendInt(worker, 1);
+    lines.Append("\"} ");
+    lines.AppendInt(station_depths[worker].load(memory_order_relaxed), 1);
+    lines.Append("\n");
+  }
+
+  AppendMetric(lines, "aprog_resident_memory_bytes",
+               "Resident set size of the simulator.", "gauge",
+               ResidentBytes());
+  AppendMetric(lines, "aprog_elapsed_seconds",
+               "Seconds since the simulation started.", "gauge", elapsed);
+
+  // The rest is only known once every precinct has been read
+  if (complete) {
+    AppendMetric(lines, "aprog_precincts_remaining",
+                 "Precincts still to simulate.", "gauge", known - done);
+    if ((done > 0) || (known == done)) {
+      double remaining = (known == done) ? 0.0
+                         : elapsed * (known - done) / done;
+      double completion = chrono::duration<double>(
+                          chrono::system_clock::now().time_since_epoch())
+                          .count() + remaining;
+      AppendMetric(lines, "aprog_estimated_remaining_seconds",
+                   "Estimated seconds until every precinct is done.",
+                   "gauge", remaining);
+      AppendMetric(lines, "aprog_estimated_completion_timestamp_seconds",
+                   "Estimated Unix time when every precinct is done.",
+                   "gauge", completion);
+    }
+  }
+  AppendMetric(lines, "aprog_run_finished",
+               "1 once the run has finished.", "gauge", final_write ? 1 : 0);
+
+  string temp_filename = metrics_filename + ".tmp";
+  ofstream out_stream(temp_filename.c_str());
+  out_stream << lines.GetString();
+  out_stream.close();
+  bool written = !out_stream.fail() &&
+                 (0 == rename(temp_filename.c_str(), metrics_filename.c_str()));
+  if (!written) {
+    cout << kTag << "ERROR: cannot write '" << metrics_filename << "'" << endl;
+    if (!ever_written)
+      exit(0);
+  }
+  ever_written = ever_written || written;
+
+  last_write_time = now;
+  last_iterations = iterations;
+  last_voters = voters;
+}
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * Header for the 'RunMetrics' class.
+ *
+ * 'RunMetrics' keeps a few running counts of a batch run and, with
+ * '--metrics=FILE', has a thread rewrite FILE every so often in the
+ * Prometheus text format, for the node-exporter textfile collector:
+ *   precincts done, known and (once the input is all read) remaining,
+ *   iterations and voters simulated, and their rates since the last write,
+ *   the station-count search depth of each worker,
+ *   the resident memory, and the estimated time left and completion time.
+ *
+ * The file is written to FILE.tmp and renamed over FILE, so a scrape never
+ * sees half a file. Counting is a relaxed atomic add, and nothing is counted
+ * unless 'Start' was called, so the simulation pays almost nothing for it.
+ * Each worker says which one it is with 'SetWorker'; a thread that never
+ * does counts as worker 0.
+**/
+
+#ifndef RUNMETRICS_H
+#define RUNMETRICS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+class RunMetrics {
+public:
+/*******************************************************************************
+ * Accessors and Mutators.
+**/
+ static bool IsRunning() {
+   return running_.load(memory_order_relaxed);
+ }
+ // Adds to the precincts known of; 'complete' once there are no more
+ static void AddPctsKnown(int count, bool complete);
+ static void CountIteration(LONG voter_count);
+ static void CountPctDone();
+ static void SetStationDepth(int depth);
+ static void SetWorker(int worker);
+
+/*******************************************************************************
+ * General functions.
+**/
+ static void Start(const string& filename, int interval_seconds,
+                   int worker_count);
+ // Writes the file a last time and stops the thread
+ static void Stop();
+
+private:
+ static atomic<bool> running_;
+
+ static void Run();
+ static void Write(bool final_write);
+};
+
+#endif // RUNMETRICS_H
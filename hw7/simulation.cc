@@ -48,17 +48,85 @@ Simulation::~Simulation() {
  * and calling the 'ReadData' for each precinct to parse the data for that
  * precinct.
  *
+ * A text file has no index, so every line is parsed and the precincts that
+ * '--pcts' did not ask for are dropped.
+ *
  * Arguments:
  *   Scanner& infile - A Scanner instance which reads data from the input file.
+ *   const Configuration& config - Says which precincts to keep.
 **/
-void Simulation::ReadPrecincts(Scanner& infile) {
+void Simulation::ReadPrecincts(Scanner& infile, const Configuration& config) {
   while (infile.HasNext()) {
     OnePct new_pct;
     new_pct.ReadData(infile);
-    pcts_[new_pct.GetPctNumber()] = new_pct;
+    if (config.IsPctSelected(new_pct.GetPctNumber()))
+      pcts_[new_pct.GetPctNumber()] = new_pct;
   } // while(infile.HasNext()){
 } // void Simulation::ReadPrecincts(Scanner& infile){
 
+/*******************************************************************************
+ * Function 'ReadPrecincts'
+ *
+ * Same as above, but the rows have already been parsed into a table.
+ *
+ * Arguments:
+ *   const PctTable& table - The parsed precinct file.
+ *   const Configuration& config - Says which precincts to keep.
+**/
+void Simulation::ReadPrecincts(const PctTable& table,
+                               const Configuration& config) {
+  for (int row = 0; row < table.GetRowCount(); ++row) {
+    if (!config.IsPctSelected(table.number_.at(row)))
+      continue;
+    OnePct new_pct;
+    new_pct.ReadRow(table, row);
+    pcts_[new_pct.GetPctNumber()] = new_pct;
+  }
+} // void Simulation::ReadPrecincts(const PctTable& table, ...)
+
+/*******************************************************************************
+ * Function 'ReadPrecincts'
+ *
+ * Same as above, but each precinct comes from a record in a mapped bundle, so
+ * nothing is parsed. The records are sorted by number, so each selected range
+ * starts with a binary search and reads only the records inside it.
+ *
+ * Arguments:
+ *   const InputBundle& bundle - An open bundle.
+ *   const Configuration& config - Says which precincts to read.
+**/
+void Simulation::ReadPrecincts(const InputBundle& bundle,
+                               const Configuration& config) {
+  vector<pair<int, int> > ranges = config.pct_ranges_;
+  if (ranges.empty())
+    ranges.push_back(make_pair(INT_MIN, INT_MAX));
+
+  for (UINT range = 0; range < ranges.size(); ++range) {
+    for (int sub = bundle.LowerBoundPct(ranges.at(range).first);
+         sub < bundle.GetPctCount(); ++sub) {
+      const PctRecord& record = bundle.ReadPct(sub);
+      if (record.number > ranges.at(range).second)
+        break;
+      OnePct new_pct;
+      new_pct.ReadRecord(record);
+      pcts_[new_pct.GetPctNumber()] = new_pct;
+    }
+  }
+} // void Simulation::ReadPrecincts(const InputBundle& bundle, ...)
+
+/*******************************************************************************
+ * Function 'GetPctRecords'
+ *
+ * Returns every precinct as a binary record, in precinct number order.
+**/
+vector<PctRecord> Simulation::GetPctRecords() const {
+  vector<PctRecord> records;
+  for (auto iterPct = pcts_.begin(); iterPct != pcts_.end(); ++iterPct) {
+    records.push_back(iterPct->second.ToRecord());
+  }
+  return records;
+} // vector<PctRecord> Simulation::GetPctRecords() const
+
 /*******************************************************************************
  * Function 'RunSimulation'
  * Commented by William Edwards, 11/30/16
@@ -68,7 +136,13 @@ void Simulation::ReadPrecincts(Scanner& infile) {
  * the range accepted for simuation.  If this check fails, then the precinct is
  * skipped.  Otherwise,  the simulation is run for that precinct by calling the
  * 'RunSimulationPct' function for that instance of 'OnePct'.  Details of this
- * process are printed to the to the output and log files.
+ * process are printed to the to the output and log files.  The wait times of
+ * every precinct, at the station count it ended with, are merged into one
+ * sketch for the county-wide wait quantiles printed at the end.
+ * With '--results=FILE' the numbers of each precinct's per-iteration lines
+ * are also appended to a results store as the precinct is written, and with
+ * '--trace=FILE' its voters are written to a voter trace a block at a time as
+ * they are simulated.
  *
  * Arguments:
  *   Configuration& config - An instance of the 'Configuration' class which
@@ -78,33 +152,53 @@ void Simulation::ReadPrecincts(Scanner& infile) {
 **/
 void Simulation::RunSimulation(const Configuration& config,
                                MyRandom& random, ofstream& out_stream) {
-  string outstring = "XX";
   int pct_count_this_batch = 0;
+  QuantileSketch county_wait_sketch;
+  ReportSink report(config.out_verbosity_, config.log_verbosity_);
+  ResultWriter results;
+  if (config.results_filename_ != "")
+    results.Open(config.results_filename_);
+  ofstream trace_stream;
+  OpenTrace(config, trace_stream);
+
+  if (RunMetrics::IsRunning()) {
+    int pct_count = 0;
+    for (auto iterPct = pcts_.begin(); iterPct != pcts_.end(); ++iterPct) {
+      if (IsSimulated(config, iterPct->second))
+        ++pct_count;
+    }
+    RunMetrics::AddPctsKnown(pct_count, true);
+  }
   
   // Loop over each precinct
   for (auto iterPct = pcts_.begin(); iterPct != pcts_.end(); ++iterPct) {
     OnePct pct = iterPct->second;
 
-    int expected_voters = pct.GetExpectedVoters();
-    if ((expected_voters <= config.min_expected_to_simulate_) ||
-        (expected_voters > config.max_expected_to_simulate_))
+    if (!IsSimulated(config, pct))
       continue;
 
-    outstring = kTag + "RunSimulation for pct " + "\n";
-    outstring.append(kTag + pct.ToString() + "\n");
-    Utils::Output(outstring, out_stream, Utils::log_stream);
-
     ++pct_count_this_batch;
     // Run simulation for precinct.
-    pct.RunSimulationPct(config, random, out_stream);
+    report.Clear();
+    if (trace_stream.is_open())
+      pct.SetTraceSink(&trace_stream);
+    SimulatePct(config, random, pct, report);
+    {
+      ScopedTimer output_timer("output");
+      OutputPct(report, out_stream);
+      if (results.IsOpen())
+        results.Append(pct.GetResults(), pct.GetPctName());
+    }
+    RunMetrics::CountPctDone();
+    county_wait_sketch.Merge(pct.GetFinalWaitSketch());
 
     //    break; // we only run one pct right now
   } // for(auto iterPct = pcts_.begin(); iterPct!=pcts_.end(); ++iterPct)
 
-  outstring = "";
-  outstring.append(kTag + "PRECINCT COUNT THIS BATCH ");
-  outstring.append(Utils::Format(pct_count_this_batch, 4) + "\n");
-  Utils::Output(outstring, out_stream, Utils::log_stream);
+  results.Close();
+  if (trace_stream.is_open())
+    Utils::FileClose(trace_stream);
+  OutputTotals(pct_count_this_batch, county_wait_sketch, out_stream);
   
 /*******************************************************************************
  * Utils::Output (outstring, out_stream);
@@ -115,6 +209,153 @@ void Simulation::RunSimulation(const Configuration& config,
 **/
 } // void Simulation::RunSimulation()
 
+/*******************************************************************************
+ * Function 'RunPipeline'
+ *
+ * Does what reading the precincts and then RunSimulation does, but as a
+ * pipeline of threads, so the first precinct's results are written while
+ * later ones are still being read and simulated:
+ *
+ *   reader  - reads one precinct at a time from the file (or a pipe, or
+ *             stdin if the file name is '-') and queues the ones to simulate
+ *   workers - config.thread_count_ of them, each simulating one precinct at
+ *             a time into a string
+ *   writer  - this thread, writing the strings in the order the precincts
+ *             were read
+ *
+ * The reader takes a ticket for each precinct and the writer gives it back
+ * once that precinct is written. There are kPipelineDepth tickets per worker,
+ * so that many precincts at most are held anywhere in the pipeline, however
+ * long the file is.
+ *
+ * With a voter trace, each worker writes a precinct's trace to a file of its
+ * own beside the trace, block by block, and the writer appends that file to
+ * the trace and removes it when the precinct's turn comes. So the trace is
+ * never held in memory, however large the precincts.
+ *
+ * Precincts come out in file order rather than by precinct number, and each
+ * one is simulated from its own random stream (the seed and the precinct
+ * number) so the results do not depend on which worker runs it. The numbers
+ * are therefore not the same as RunSimulation's, but they are the same for
+ * any number of workers.
+ *
+ * Arguments:
+ *   Configuration& config - The configuration, with the run options.
+ *   const string& pct_filename - The precinct file, or '-' for stdin.
+ *   ofstream& out_stream - A data stream corresponding to the output file.
+**/
+void Simulation::RunPipeline(const Configuration& config,
+                             const string& pct_filename,
+                             ofstream& out_stream) {
+  int worker_count = config.thread_count_;
+  int depth = kPipelineDepth * worker_count;
+
+  BoundedQueue<PipelineItem> to_simulate(depth);
+  BoundedQueue<PipelineItem> to_write(depth);
+  BoundedQueue<int> tickets(depth);
+  for (int ticket = 0; ticket < depth; ++ticket) {
+    tickets.Push(ticket);
+  }
+
+  thread reader([&]() {
+    EventTrace::NameThread("reader");
+    Scanner infile;
+    infile.OpenFile(("-" == pct_filename) ? "/dev/stdin" : pct_filename);
+    int sequence = 0;
+    while (infile.HasNext()) {
+      PipelineItem item;
+      {
+        ScopedTimer read_timer("read");
+        item.pct.ReadData(infile);
+      }
+      if (!config.IsPctSelected(item.pct.GetPctNumber()) ||
+          !IsSimulated(config, item.pct))
+        continue;
+
+      int ticket = 0;
+      tickets.Pop(ticket);
+      item.sequence = sequence;
+      ++sequence;
+      RunMetrics::AddPctsKnown(1, false);
+      to_simulate.Push(std::move(item));
+      EventTrace::AddCounter("to simulate", to_simulate.Size());
+    }
+    infile.Close();
+    RunMetrics::AddPctsKnown(0, true);
+    to_simulate.Close();
+  });
+
+  atomic<int> workers_left(worker_count);
+  vector<thread> workers;
+  for (int worker = 0; worker < worker_count; ++worker) {
+    workers.push_back(thread([&, worker]() {
+      EventTrace::NameThread("worker " + to_string(worker));
+      RunMetrics::SetWorker(worker);
+      PipelineItem item;
+      while (to_simulate.Pop(item)) {
+        MyRandom random(config.seed_, item.pct.GetPctNumber());
+        item.report = ReportSink(config.out_verbosity_, config.log_verbosity_);
+        ofstream part_stream;
+        if (config.trace_filename_ != "") {
+          OpenTracePart(config, item.sequence, part_stream);
+          item.pct.SetTraceSink(&part_stream);
+        }
+        SimulatePct(config, random, item.pct, item.report);
+        item.pct.SetTraceSink(nullptr);
+        part_stream.close();
+        to_write.Push(std::move(item));
+        EventTrace::AddCounter("to write", to_write.Size());
+      }
+      if (0 == --workers_left)
+        to_write.Close();
+    }));
+  }
+
+  // Results can finish out of order; hold them until their turn
+  int pct_count_this_batch = 0;
+  QuantileSketch county_wait_sketch;
+  ResultWriter results;
+  if (config.results_filename_ != "")
+    results.Open(config.results_filename_);
+  ofstream trace_stream;
+  OpenTrace(config, trace_stream);
+  map<int, PipelineItem> finished;
+  PipelineItem item;
+  while (to_write.Pop(item)) {
+    finished[item.sequence] = std::move(item);
+    EventTrace::AddCounter("held for order",
+                           static_cast<LONG>(finished.size()));
+    for (auto next = finished.find(pct_count_this_batch);
+         next != finished.end();
+         next = finished.find(pct_count_this_batch)) {
+      {
+        ScopedTimer output_timer("output");
+        OutputPct(next->second.report, out_stream);
+        if (results.IsOpen())
+          results.Append(next->second.pct.GetResults(),
+                         next->second.pct.GetPctName());
+        if (trace_stream.is_open())
+          AppendTracePart(config, next->second.sequence, trace_stream);
+      }
+      RunMetrics::CountPctDone();
+      county_wait_sketch.Merge(next->second.pct.GetFinalWaitSketch());
+      finished.erase(next);
+      ++pct_count_this_batch;
+      tickets.Push(0);
+    }
+  }
+
+  reader.join();
+  for (UINT worker = 0; worker < workers.size(); ++worker) {
+    workers.at(worker).join();
+  }
+
+  results.Close();
+  if (trace_stream.is_open())
+    Utils::FileClose(trace_stream);
+  OutputTotals(pct_count_this_batch, county_wait_sketch, out_stream);
+} // void Simulation::RunPipeline(...)
+
 /*******************************************************************************
  * Function 'ToString'.
  * Commented by William Edwards, 11/30/16
@@ -133,3 +374,121 @@ string Simulation::ToString() {
 
   return s;
 } // string Simulation::ToString()
+
+/*******************************************************************************
+ * Function 'AppendTracePart'
+ *
+ * Appends the trace a pipeline worker wrote for the precinct at 'sequence' to
+ * the voter trace, and removes it.
+**/
+void Simulation::AppendTracePart(const Configuration& config, int sequence,
+                                 ofstream& trace_stream) {
+  string filename = TracePartName(config, sequence);
+  ifstream part_stream(filename.c_str(), ios::binary);
+  if (part_stream.peek() != ifstream::traits_type::eof())
+    trace_stream << part_stream.rdbuf();
+  part_stream.close();
+  remove(filename.c_str());
+} // void Simulation::AppendTracePart(...)
+
+/*******************************************************************************
+ * Function 'IsSimulated'
+ *
+ * True if the precinct's expected voters are in the configured range.
+**/
+bool Simulation::IsSimulated(const Configuration& config, const OnePct& pct) {
+  int expected_voters = pct.GetExpectedVoters();
+  return (expected_voters > config.min_expected_to_simulate_) &&
+         (expected_voters <= config.max_expected_to_simulate_);
+} // bool Simulation::IsSimulated(...)
+
+/*******************************************************************************
+ * Function 'OpenTrace'
+ *
+ * Opens the voter trace and writes its header, if the configuration asks for
+ * one. The precincts' traces are appended as they are written.
+**/
+void Simulation::OpenTrace(const Configuration& config,
+                           ofstream& trace_stream) {
+  if (config.trace_filename_ == "")
+    return;
+  Utils::FileOpen(trace_stream, config.trace_filename_);
+  VoterTrace::WriteHeader(trace_stream);
+} // void Simulation::OpenTrace(...)
+
+/*******************************************************************************
+ * Function 'OpenTracePart'
+ *
+ * Opens the file a pipeline worker writes one precinct's trace to, or stops
+ * the program if it cannot.
+**/
+void Simulation::OpenTracePart(const Configuration& config, int sequence,
+                               ofstream& part_stream) {
+  string filename = TracePartName(config, sequence);
+  part_stream.open(filename.c_str(), ios::binary | ios::trunc);
+  if (part_stream.fail()) {
+    cout << kTag << "ERROR: cannot open trace part '" << filename << "'\n";
+    exit(0);
+  }
+} // void Simulation::OpenTracePart(...)
+
+/*******************************************************************************
+ * Function 'OutputTotals'
+ *
+ * Writes the precinct count and the county-wide wait quantiles. The end of a
+ * batch is a flush point, so a batch's results are on disk once it is done.
+**/
+void Simulation::OutputTotals(int pct_count, const QuantileSketch& wait_sketch,
+                              ofstream& out_stream) {
+  string outstring = "";
+  outstring.append(kTag + "PRECINCT COUNT THIS BATCH ");
+  outstring.append(Utils::Format(pct_count, 4) + "\n");
+  outstring.append(kTag + "COUNTY WAIT p50/90/95/99 ");
+  outstring.append(OnePct::FormatQuantiles(wait_sketch) + "\n");
+  Utils::Output(outstring, out_stream, Utils::log_stream);
+  Utils::FlushOutput();
+} // void Simulation::OutputTotals(...)
+
+/*******************************************************************************
+ * Function 'OutputPct'
+ *
+ * Writes one precinct's report, the same text to both files if they have the
+ * same verbosity and otherwise each file's own.
+**/
+void Simulation::OutputPct(const ReportSink& report, ofstream& out_stream) {
+  if (report.IsShared()) {
+    Utils::Output(report.GetOutText(), out_stream, Utils::log_stream);
+    return;
+  }
+  if (!report.GetOutText().empty())
+    Utils::Output(report.GetOutText(), out_stream);
+  if (!report.GetLogText().empty())
+    Utils::Output(report.GetLogText(), Utils::log_stream);
+} // void Simulation::OutputPct(...)
+
+/*******************************************************************************
+ * Function 'SimulatePct'
+ *
+ * Simulates one precinct into 'report', headed by the precinct's description.
+**/
+void Simulation::SimulatePct(const Configuration& config, MyRandom& random,
+                             OnePct& pct, ReportSink& report) {
+  ScopedTimer pct_timer("pct", pct.GetPctNumber());
+  report.Emit(kVerbosePerCount, [&](Formatter& line) {
+    line.Append(kTag + "RunSimulation for pct \n");
+    line.Append(kTag);
+    pct.AppendTo(line);
+    line.Append("\n");
+  });
+  pct.RunSimulationPct(config, random, report);
+} // void Simulation::SimulatePct(...)
+
+/*******************************************************************************
+ * Function 'TracePartName'
+ *
+ * The file a pipeline worker writes the precinct at 'sequence' to, beside
+ * the voter trace.
+**/
+string Simulation::TracePartName(const Configuration& config, int sequence) {
+  return config.trace_filename_ + ".part" + to_string(sequence);
+} // string Simulation::TracePartName(...)
@@ -15,8 +15,16 @@
 #ifndef SIMULATION_H
 #define SIMULATION_H
 
+#include <atomic>
 #include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
 
+#include "../Utilities/boundedqueue.h"
+#include "../Utilities/eventtrace.h"
+#include "../Utilities/reportsink.h"
+#include "../Utilities/scopedtimer.h"
 #include "../Utilities/utils.h"
 #include "../Utilities/scanner.h"
 #include "../Utilities/scanline.h"
@@ -24,7 +32,13 @@
 using namespace std;
 
 #include "configuration.h"
+#include "inputbundle.h"
 #include "onepct.h"
+#include "resultwriter.h"
+#include "runmetrics.h"
+
+// Precincts the pipeline may hold for each worker
+static const int kPipelineDepth = 4;
 
 class Simulation {
 public:
@@ -47,8 +61,40 @@ public:
  *
  * Arguments:
  *   Scanner& infile - A Scanner instance which reads data from the input file.
+ *   const Configuration& config - Says which precincts to keep.
+**/
+  void ReadPrecincts(Scanner& infile, const Configuration& config);
+
+/*******************************************************************************
+ * Function 'ReadPrecincts'
+ *
+ * Reads the selected precincts from a precinct table parsed in parallel.
+ *
+ * Arguments:
+ *   const PctTable& table - The parsed precinct file.
+ *   const Configuration& config - Says which precincts to keep.
 **/
-  void ReadPrecincts(Scanner& infile);
+  void ReadPrecincts(const PctTable& table, const Configuration& config);
+
+/*******************************************************************************
+ * Function 'ReadPrecincts'
+ *
+ * Reads the selected precincts from the records of a mapped input bundle,
+ * looking each range up by binary search.
+ *
+ * Arguments:
+ *   const InputBundle& bundle - An open bundle.
+ *   const Configuration& config - Says which precincts to read.
+**/
+  void ReadPrecincts(const InputBundle& bundle, const Configuration& config);
+
+/*******************************************************************************
+ * Function 'GetPctRecords'
+ *
+ * Returns every precinct as a binary record, in precinct number order, for
+ * writing an input bundle.
+**/
+  vector<PctRecord> GetPctRecords() const;
 
 
 /*******************************************************************************
@@ -65,6 +111,21 @@ public:
 **/
   void RunSimulation(const Configuration& config, MyRandom& random,
                      ofstream& out_stream);
+
+/*******************************************************************************
+ * Function 'RunPipeline'
+ *
+ * Reads, simulates and writes the precincts of a text file as a pipeline of
+ * threads joined by bounded queues, holding only a few precincts at a time.
+ *
+ * Arguments:
+ *   Configuration& config - The configuration, with the run options.
+ *   const string& pct_filename - The precinct file, or '-' for stdin.
+ *   ofstream& out_stream - A data stream corresponding to the output file.
+**/
+  void RunPipeline(const Configuration& config, const string& pct_filename,
+                   ofstream& out_stream);
+
 /*******************************************************************************
  * Function 'ToString'.
  * Commented by William Edwards, 11/30/16
@@ -90,10 +151,31 @@ private:
 **/
   map<int, OnePct> pcts_;
 
+/*******************************************************************************
+ * One precinct on its way through the pipeline. 'sequence' is its place in
+ * the file and 'report' is what it wrote.
+**/
+  struct PipelineItem {
+    int sequence = 0;
+    OnePct pct;
+    ReportSink report;
+  };
+
 /*******************************************************************************
  * Private functions.
 **/
-  
+  static void AppendTracePart(const Configuration& config, int sequence,
+                              ofstream& trace_stream);
+  static bool IsSimulated(const Configuration& config, const OnePct& pct);
+  static void OpenTrace(const Configuration& config, ofstream& trace_stream);
+  static void OpenTracePart(const Configuration& config, int sequence,
+                            ofstream& part_stream);
+  static void OutputTotals(int pct_count, const QuantileSketch& wait_sketch,
+                           ofstream& out_stream);
+  static void OutputPct(const ReportSink& report, ofstream& out_stream);
+  static void SimulatePct(const Configuration& config, MyRandom& random,
+                          OnePct& pct, ReportSink& report);
+  static string TracePartName(const Configuration& config, int sequence);
 };
 
 #endif // SIMULATION_H
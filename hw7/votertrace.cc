@@ -0,0 +1,277 @@
+#include "votertrace.h"
+/*******************************************************************************
+ * Implementation for the 'VoterTrace' class.
+**/
+
+static const string kTag = "TRACE: ";
+
+/*******************************************************************************
+ * Constructor.
+**/
+VoterTrace::VoterTrace() {
+  memset(&block_, 0, sizeof(block_));
+}
+
+/*******************************************************************************
+ * Destructor.
+**/
+VoterTrace::~VoterTrace() {
+}
+
+/*******************************************************************************
+ * Accessors and mutators.
+**/
+void VoterTrace::SetSink(ostream* sink) {
+  sink_ = sink;
+}
+
+/*******************************************************************************
+ * General functions.
+**/
+
+/*******************************************************************************
+ * Function 'AddVoter'.
+ * Encodes one voter at the end of the current block, starting another block
+ * if this one is full.
+**/
+void VoterTrace::AddVoter(int sequence, int arrival, int start, int duration,
+                          int station) {
+  assert(in_block_);
+  if (static_cast<int>(block_.voter_count) == kTraceBlockVoters) {
+    this->EndBlock();
+    this->StartBlock();
+  }
+
+  int sequence_step = sequence - previous_sequence_;
+  this->PutVarint(ZigZag(arrival - previous_arrival_));
+  this->PutVarint(static_cast<uint64_t>(static_cast<LONG>(start - arrival)));
+  this->PutVarint(static_cast<uint64_t>(static_cast<LONG>(duration)));
+  uint64_t station_and_flag = static_cast<uint64_t>(station) * 2;
+  if (sequence_step != 1) {
+    this->PutVarint(station_and_flag + 1);
+    this->PutVarint(ZigZag(sequence_step));
+  } else {
+    this->PutVarint(station_and_flag);
+  }
+
+  previous_sequence_ = sequence;
+  previous_arrival_ = arrival;
+  ++block_.voter_count;
+}
+
+/*******************************************************************************
+ * Function 'BeginIteration'.
+ * Starts the block for one iteration; its voters follow with 'AddVoter'.
+**/
+void VoterTrace::BeginIteration(int pct_number, int station_count,
+                                int iteration) {
+  assert(!in_block_);
+  assert(nullptr != sink_);
+  block_.pct_number = pct_number;
+  block_.station_count = station_count;
+  block_.iteration = iteration;
+  this->StartBlock();
+}
+
+void VoterTrace::Clear() {
+  bytes_.clear();
+  in_block_ = false;
+}
+
+/*******************************************************************************
+ * Function 'EndIteration'.
+**/
+void VoterTrace::EndIteration() {
+  assert(in_block_);
+  this->EndBlock();
+  in_block_ = false;
+}
+
+/*******************************************************************************
+ * Function 'WriteHeader'.
+**/
+void VoterTrace::WriteHeader(ofstream& out_stream) {
+  TraceHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+  header.version = kTraceVersion;
+  header.header_bytes = sizeof(TraceHeader);
+  out_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+/*******************************************************************************
+ * Function 'IsTrace'.
+**/
+bool VoterTrace::IsTrace(const string& filename) {
+  MappedFile file;
+  if (!file.Open(filename) || (file.GetSize() < sizeof(kTraceMagic)))
+    return false;
+  return 0 == memcmp(file.GetData(), kTraceMagic, sizeof(kTraceMagic));
+}
+
+/*******************************************************************************
+ * Function 'Print'.
+ * Maps a trace and decodes it block by block, writing the voters of the
+ * blocks asked for the same way OnePct::ToStringVoterMap does, under a
+ * heading for each iteration. The blocks not asked for are skipped by their
+ * byte counts. A block that does not decode to its own count of voters in
+ * its own bytes is reported and stops the program.
+**/
+void VoterTrace::Print(const string& filename, int pct_number,
+                       int station_count, ostream& out_stream) {
+  MappedFile file;
+  if (!file.Open(filename))
+    Fail(filename, "cannot be mapped");
+  if (file.GetSize() < sizeof(TraceHeader))
+    Fail(filename, "is too short to be a trace");
+  TraceHeader header;
+  memcpy(&header, file.GetData(), sizeof(header));
+  if (0 != memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)))
+    Fail(filename, "is not a trace");
+  if ((kTraceVersion != header.version) ||
+      (sizeof(TraceHeader) != header.header_bytes))
+    Fail(filename, "is not trace version " +
+                   Utils::Format(static_cast<int>(kTraceVersion)));
+
+  const char* next = file.GetData() + sizeof(TraceHeader);
+  const char* end = file.GetData() + file.GetSize();
+  bool printed = false;
+  TraceBlockHeader heading;
+  memset(&heading, 0, sizeof(heading));
+  Formatter lines;
+
+  while (next < end) {
+    TraceBlockHeader block;
+    if (static_cast<size_t>(end - next) < sizeof(block))
+      Fail(filename, "ends in the middle of a block");
+    memcpy(&block, next, sizeof(block));
+    next += sizeof(block);
+    if (static_cast<size_t>(end - next) < block.byte_count)
+      Fail(filename, "has a block past the end of the file");
+    const char* block_end = next + block.byte_count;
+
+    if (((pct_number >= 0) && (block.pct_number != pct_number)) ||
+        ((station_count >= 0) && (block.station_count != station_count))) {
+      next = block_end;
+      continue;
+    }
+
+    lines.Clear();
+    if (!printed || (heading.pct_number != block.pct_number) ||
+        (heading.station_count != block.station_count) ||
+        (heading.iteration != block.iteration)) {
+      lines.Append("\n" + kTag + "pct ");
+      lines.AppendInt(block.pct_number, 4);
+      lines.Append(" stations ");
+      lines.AppendInt(block.station_count, 4);
+      lines.Append(" iteration ");
+      lines.AppendInt(block.iteration, 3);
+      lines.Append("\n");
+      lines.Append(OneVoter::ToStringHeader());
+      lines.Append("\n");
+      heading = block;
+      printed = true;
+    }
+
+    LONG sequence = -1;
+    LONG arrival = 0;
+    for (uint32_t voter = 0; voter < block.voter_count; ++voter) {
+      uint64_t arrival_step = 0;
+      uint64_t wait = 0;
+      uint64_t duration = 0;
+      uint64_t station_and_flag = 0;
+      uint64_t sequence_step = ZigZag(1);
+      if (!GetVarint(next, block_end, arrival_step) ||
+          !GetVarint(next, block_end, wait) ||
+          !GetVarint(next, block_end, duration) ||
+          !GetVarint(next, block_end, station_and_flag) ||
+          ((1 == (station_and_flag & 1)) &&
+           !GetVarint(next, block_end, sequence_step)))
+        Fail(filename, "has a block shorter than its voters");
+
+      sequence += UnZigZag(sequence_step);
+      arrival += UnZigZag(arrival_step);
+      OneVoter one_voter(static_cast<int>(sequence), static_cast<int>(arrival),
+                         static_cast<int>(duration));
+      one_voter.AssignStation(static_cast<int>(station_and_flag / 2),
+                              static_cast<int>(arrival
+                                               + static_cast<LONG>(wait)));
+      one_voter.AppendTo(lines);
+      lines.Append("\n");
+    }
+    if (next != block_end)
+      Fail(filename, "has a block longer than its voters");
+
+    out_stream << lines.GetString();
+  }
+}
+
+/*******************************************************************************
+ * Fill in the current block's header now that its size is known, and send
+ * the block to the sink.
+**/
+void VoterTrace::EndBlock() {
+  block_.byte_count = static_cast<uint32_t>(bytes_.size() - block_start_
+                                            - sizeof(TraceBlockHeader));
+  memcpy(&bytes_[block_start_], &block_, sizeof(block_));
+  sink_->write(bytes_.data(), bytes_.size());
+  bytes_.clear();
+}
+
+/*******************************************************************************
+ * Report a bad trace and stop.
+**/
+void VoterTrace::Fail(const string& filename, const string& why) {
+  cout << kTag << "ERROR: '" << filename << "' " << why << endl;
+  exit(0);
+}
+
+/*******************************************************************************
+ * Read one varint, seven bits a byte, low bits first, the high bit set on
+ * every byte but the last. False if it runs past 'end'.
+**/
+bool VoterTrace::GetVarint(const char*& next, const char* end,
+                           uint64_t& value) {
+  value = 0;
+  for (int shift = 0; (next < end) && (shift < 64); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(*next);
+    ++next;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (0 == (byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+void VoterTrace::PutVarint(uint64_t value) {
+  while (value >= 0x80) {
+    bytes_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  bytes_.push_back(static_cast<char>(value));
+}
+
+/*******************************************************************************
+ * Leave room for a block header and start the differences afresh.
+**/
+void VoterTrace::StartBlock() {
+  block_start_ = bytes_.size();
+  bytes_.append(sizeof(TraceBlockHeader), '\0');
+  block_.voter_count = 0;
+  block_.byte_count = 0;
+  previous_sequence_ = -1;
+  previous_arrival_ = 0;
+  in_block_ = true;
+}
+
+/*******************************************************************************
+ * Signed to unsigned with the small magnitudes first: 0, -1, 1, -2, ...
+**/
+uint64_t VoterTrace::ZigZag(LONG value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+LONG VoterTrace::UnZigZag(uint64_t value) {
+  return static_cast<LONG>(value >> 1) ^ -static_cast<LONG>(value & 1);
+}
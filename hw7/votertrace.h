@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Header for the 'VoterTrace' class.
+ *
+ * A voter trace is a compact binary record of every voter of every iteration:
+ * sequence, arrival, start, duration and station, the numbers behind
+ * OneVoter::ToString at a few bytes a voter instead of about eighty. Aprog
+ * writes one with '--trace=FILE' and Rprog prints it back as voter lines.
+ *
+ * Layout (native byte order):
+ *   TraceHeader
+ *   blocks, each a TraceBlockHeader and then 'byte_count' bytes of voters
+ *
+ * A block is one iteration of one precinct at one station count, or part of
+ * one if it has more than kTraceBlockVoters voters. Its voters are in
+ * sequence order and each is, as unsigned LEB128 varints:
+ *   arrival - previous arrival, zigzag coded
+ *   start - arrival, the wait
+ *   duration
+ *   station * 2, plus 1 if the sequence is not the previous one + 1, in
+ *     which case the sequence difference follows, zigzag coded
+ * Arrivals are close together and waits, durations and stations are small, so
+ * most voters take 4 to 6 bytes. Every block starts its differences afresh,
+ * so blocks can be read, or skipped, on their own.
+ *
+ * While writing, each block goes to the sink stream as soon as it is closed,
+ * so at most one block is held in memory however many voters are traced.
+**/
+
+#ifndef VOTERTRACE_H
+#define VOTERTRACE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../Utilities/formatter.h"
+#include "../Utilities/mappedfile.h"
+#include "../Utilities/utils.h"
+
+using namespace std;
+
+#include "onevoter.h"
+
+static const char kTraceMagic[8] = {'A', 'P', 'R', 'O', 'G', 'T', 'R', 'C'};
+static const uint32_t kTraceVersion = 1;
+static const int kTraceBlockVoters = 65536;
+
+struct TraceHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_bytes;
+};
+
+struct TraceBlockHeader {
+  int32_t pct_number;
+  int32_t station_count;
+  int32_t iteration;
+  uint32_t voter_count;
+  uint32_t byte_count;
+  uint32_t unused;
+};
+
+class VoterTrace {
+public:
+/*******************************************************************************
+ * Constructors and destructors for the class.
+**/
+ VoterTrace();
+ virtual ~VoterTrace();
+
+/*******************************************************************************
+ * Accessors and Mutators.
+**/
+ // Where the blocks are written as they are closed
+ void SetSink(ostream* sink);
+
+/*******************************************************************************
+ * General functions, for writing.
+**/
+ void AddVoter(int sequence, int arrival, int start, int duration,
+               int station);
+ void BeginIteration(int pct_number, int station_count, int iteration);
+ void Clear();
+ void EndIteration();
+ // Starts a trace file with its header
+ static void WriteHeader(ofstream& out_stream);
+
+/*******************************************************************************
+ * General functions, for reading.
+**/
+ // Returns true if the file starts with the trace magic number
+ static bool IsTrace(const string& filename);
+ // Writes the voters of the blocks that match as OneVoter lines; a
+ // 'pct_number' or 'station_count' below zero matches everything
+ static void Print(const string& filename, int pct_number, int station_count,
+                   ostream& out_stream);
+
+private:
+ string bytes_;
+ ostream* sink_ = nullptr;
+ TraceBlockHeader block_;
+ size_t block_start_ = 0;
+ bool in_block_ = false;
+ int previous_sequence_ = 0;
+ int previous_arrival_ = 0;
+
+ void EndBlock();
+ void PutVarint(uint64_t value);
+ void StartBlock();
+ static void Fail(const string& filename, const string& why);
+ static bool GetVarint(const char*& next, const char* end, uint64_t& value);
+ static uint64_t ZigZag(LONG value);
+ static LONG UnZigZag(uint64_t value);
+};
+
+#endif // VOTERTRACE_H